@@ -0,0 +1,69 @@
+/* !
+@file    glheadless.h
+@author  Jia Min / j.jiamin@digipen.edu
+@date    17/10/2026
+This file contains what GLPbo needs from GL, GLEW and GLFW when it is built
+with GLPBO_HEADLESS for machines without a display: the GL types the
+emulator is written in, and a GLHelper that keeps the key states and the
+clock GLPbo::emulate() reads, without a window or an OpenGL context.
+*//*__________________________________________________________________________*/
+/*                                                                      guard
+----------------------------------------------------------------------------- */
+#ifndef GLHEADLESS_H
+#define GLHEADLESS_H
+/*                                                                   includes
+----------------------------------------------------------------------------- */
+#include <glm/glm.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <vector>
+
+// the GL types used by the emulator, as declared by GL/glew.h
+typedef unsigned int GLenum;
+typedef unsigned char GLboolean;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned int GLuint;
+typedef unsigned char GLubyte;
+typedef unsigned short GLushort;
+typedef float GLfloat;
+typedef double GLdouble;
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+
+/*  _________________________________________________________________________ */
+struct GLHelper
+  /*! GLHelper of the headless build. Keys are pressed by setting their
+  state for a frame, and time advances by frame_time with every call to
+  update_time() so that a run renders the same frames on every machine.
+  */
+{
+  static double update_time(double fpsCalcInt = 1.0);
+  static GLboolean mouseLeft;
+  static GLboolean keystateA;
+  static GLboolean keystateC;
+  static GLboolean keystateH;
+  static GLboolean keystateK;
+  static GLboolean keystateM;
+  static GLboolean keystateR;
+  static GLboolean keystateT;
+  static GLboolean keystateU;
+  static GLboolean keystateV;
+  static GLboolean keystateW;
+  static GLboolean keystateZ;
+  static GLint width, height;
+  // frames per second measured on the wall clock
+  static GLdouble fps;
+  static std::string title;
+  // status line GLPbo::emulate() writes to the window title otherwise
+  static std::string status;
+  // seconds since the first frame, and the step update_time() advances it by
+  static GLdouble time;
+  static GLdouble frame_time;
+  static void print_specs ();
+};
+#endif /* GLHEADLESS_H */
@@ -45,6 +45,7 @@ struct GLHelper
   static GLboolean mouseLeft;
 
   static GLboolean keystateA;
+  static GLboolean keystateC;
   static GLboolean keystateH;
   static GLboolean keystateK;
   static GLboolean keystateM;
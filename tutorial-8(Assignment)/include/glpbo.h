@@ -72,10 +72,34 @@ the previous step. This is done by calling GLPbo::draw_fullwindow_quad().
 
 /*                                                                   includes
 ----------------------------------------------------------------------------- */
+#if defined( GLPBO_HEADLESS )
+#include <glheadless.h> // GL types and a GLHelper without window or context
+#else
 #include <GL/glew.h> // for access to OpenGL API declarations 
 #include <glslshader.h> // GLSLShader class definition
 #include <glhelper.h>
+#endif
 #include <dpml.h>
+#include <vector>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// vector width of the coverage kernel is picked at compile time
+#if defined( __AVX2__ )
+#define GLPBO_AVX2
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define GLPBO_SSE2
+#endif
+#if defined( GLPBO_AVX2 ) || defined( GLPBO_SSE2 )
+#include <immintrin.h>
+#endif
+
+// define GLPBO_TRACE to build the timing markers of GLPbo::Trace in, they
+// compile to nothing otherwise
 
 /*  _________________________________________________________________________ */
 struct GLPbo
@@ -94,15 +118,59 @@ struct GLPbo
 	// it generates images using set_pixel to write to the PBO
 	static void emulate ();
 
+#if !defined( GLPBO_HEADLESS )
 	// render quad using the texture image generated by render()
 	static void draw_fullwindow_quad ();
+#endif
 
 	// initialization and cleanup stuff ...
 	static void init ( GLsizei w , GLsizei h );
+#if !defined( GLPBO_HEADLESS )
 	static void setup_quad_vao ();
 	static void setup_shdrpgm ();
+#endif
 	static void cleanup ();
 
+	// loads an OBJ mesh into all_model_data , false if it could not be parsed
+	static bool load_model ( std::string const& file );
+
+	// the state the W and M keys step through, for the benchmark to set
+	// directly. Modes are numbered in the order W cycles through them
+	static int mode_count ();
+	static char const* mode_name ( int index );
+	static void select ( int index , int model );
+	struct PipelineStatistics
+		/*! counters of a frame after GL_ARB_pipeline_statistics_query. Every
+		thread counts into a copy of its own, which emulate () adds up once
+		the tiles of the frame are done, so no counter is shared while
+		rendering.
+		*/
+	{
+		// bucket b of pixels_per_triangle counts the triangles that covered
+		// [ 2^(b-1) , 2^b ) pixels over all tiles, bucket 0 the ones that
+		// passed culling but covered none
+		static constexpr int histogram_buckets = 16;
+
+		std::uint64_t vertices{};           // vertices of the visible meshlets, transformed or reused
+		std::uint64_t primitives{};         // triangles submitted
+		std::uint64_t clipped{};            // triangles clipped against the guard band or depth range
+		std::uint64_t culled{};             // triangles culled, outside, back-facing or clipped away
+		std::uint64_t pixels{};             // pixels whose coverage was tested
+		std::uint64_t depth_passed{};       // covered pixels that passed the depth test
+		std::uint64_t depth_failed{};       // covered pixels that failed it
+		std::uint64_t fragments{};          // fragments shaded, and pixels of the lines in wireframe
+		std::uint64_t texture_samples{};    // texture lookups of the shaders
+		std::uint64_t pixels_per_triangle[ histogram_buckets ]{};
+
+		void Add ( PipelineStatistics const& other );
+	};
+	// counters of the last frame , as shown in the window title
+	static PipelineStatistics const& statistics ();
+#if defined( GLPBO_HEADLESS )
+	// a windowed build keeps the size its PBO and texture were created with
+	static void resize ( GLsizei w , GLsizei h );
+#endif
+
 	// ---------------static data members are declared here ----------------
 
 	// Storage requirements common to emulator, PBO and texture object
@@ -111,9 +179,12 @@ struct GLPbo
 	// GLPbo::init() and then forget ...
 	static GLsizei pixel_cnt , byte_cnt; // how many pixels and bytes
 	// pointer to PBO's memory chunk - must be set every frame with the value 
-	// returned by glMapNamedBuffer()
+	// returned by glMapNamedBuffer(). A headless build has no PBO and renders
+	// into a buffer of its own, aligned to a cache line and allocated once by
+	// init()
 	static Color* ptr_to_pbo;
 
+#if !defined( GLPBO_HEADLESS )
 	// geometry and material information ...
 	static GLuint vaoid;        // with GL 4.5, VBO & EBO are not required
 	static GLuint elem_cnt;     // how many indices in element buffer
@@ -121,6 +192,7 @@ struct GLPbo
 	static GLuint texid;        // id for texture object
 	static GLSLShader shdr_pgm; // object that abstracts away nitty-gritty
 								// details of shader management
+#endif
 
 	// --- here we're trying to emulate GL's functions for clearing colorbuffer ---
 
@@ -154,6 +226,31 @@ struct GLPbo
 		{}
 	};
 
+	struct Meshlet
+		/*! run of consecutive triangles of Model::tri with the bounds that let
+		the vertex stage reject all of them at once
+		*/
+	{
+		GLuint triangle_offset , triangle_cnt;	// range of triangles ( not indices )
+		GLuint vertex_begin , vertex_end;		// vertices transformed with this meshlet
+		GLuint source_offset , source_cnt;		// earlier meshlets in Model::meshlet_sources
+												// owning the other vertices it uses
+		glm::vec3 center;						// bounding sphere in model space
+		float radius;
+		glm::vec3 cone_axis;					// normal cone in model space, every triangle
+		float cone_cutoff;						// faces away when dot ( cone_axis , view ) < cone_cutoff
+	};
+
+	struct Edge
+		/*! an edge of Model::tri with the triangles on either side. A side is
+		the offset into Model::tri of the corner the edge starts at in the
+		winding of that triangle, face1 is no_face on an open border.
+		*/
+	{
+		GLuint face0 , face1;
+	};
+	static constexpr GLuint no_face = ~0u;
+
 	struct Model
 	{
 		// vertex position array pm 
@@ -169,6 +266,27 @@ struct GLPbo
 		std::vector<glm::vec3> pd;
 
 		glm::mat3 model_transform ;
+
+		// structure-of-arrays copy of pm read by the vertex stage
+		std::vector<float> pm_x , pm_y , pm_z;
+		// matrix pd was last transformed with, pd is only recomputed when it changes
+		glm::mat4 pd_matrix{ 0.0f };
+
+		// meshlets built at import, and the ones that passed the culling of the
+		// vertex stage for pd_matrix. Only their vertices are up to date in pd
+		std::vector<Meshlet> meshlets;
+		std::vector<GLuint> meshlet_sources;
+		std::vector<GLuint> visible_meshlets;
+		// vertices the visible meshlets and their sources own, the vertex
+		// count of every frame drawn with pd_matrix
+		size_t visible_vertices{};
+
+		// every edge once, built at import for the wireframe mode
+		std::vector<Edge> edges;
+
+		// geometric error of this level of detail against the mesh it was
+		// simplified from, in model units
+		float lod_error{ 0.0f };
 	};
 
 	struct PointLight
@@ -176,45 +294,435 @@ struct GLPbo
 		glm::vec3 intensity;
 		glm::vec3 position;
 		glm::vec3 transform_position;
+		// distance at which the light has faded out, 0 for a light that
+		// reaches everything without falling off
+		float radius{ 0.0f };
 	};
 
 	struct Texture
+		/*! RGBA8 texels stored in tiles of 4x4, so that a tile fills one 64 byte
+		cache line and most bilinear footprints stay within one. The tiles are
+		stored row by row, and so are the texels within a tile.
+		*/
 	{
+		// filter within a mip level
+		enum class Filter { nearest , bilinear };
+		// level 0 only, the nearest mip level, or a blend of the two nearest
+		enum class MipFilter { none , nearest , linear };
+		// repeat the image, clamp to its edge texels or return border outside it
+		enum class Wrap { repeat , clamp , border };
+		// rgba8 keeps the texels as they are, bc1 and bc3 keep every 4x4 tile as
+		// a compressed block of 8 and 16 bytes that is decoded when sampled
+		enum class Format { rgba8 , bc1 , bc3 };
+
+		struct Level
+			/*! one image of the mip chain, each half the size of the one before */
+		{
+			int width , height;
+			int tiles_x;
+			size_t first;	// storage index of its first tile
+
+			// index of texel ( x , y ) from storage[ first ], both within the image
+			int Offset ( int x , int y ) const
+			{
+				return ( ( ( y >> 2 ) * tiles_x + ( x >> 2 ) ) << 4 ) | ( ( y & 3 ) << 2 ) | ( x & 3 );
+			}
+		};
+
 		int twidth{} , theight{};
-		std::vector<glm::vec3> data;
+		Filter filter{ Filter::nearest };
+		MipFilter mip_filter{ MipFilter::none };
+		Wrap wrap{ Wrap::border };
+		Format format{ Format::rgba8 };
+		Color border{ 255 , 255 , 255 , 255 };
+
+		// loads the image and builds its mip chain
 		void ReadFile ( const std::string& filename );
-		glm::vec3 GetColor ( const glm::vec2& tex );
+		// block-compresses every level of a loaded rgba8 texture and releases
+		// its texels
+		void Compress ( Format to );
+		// memory taken by the texels or blocks of all levels
+		size_t Bytes () const;
+		// level of detail from the screen-space derivatives of the texture
+		// coordinates, log2 of the texels a pixel steps over
+		float Lod ( glm::vec2 const& ddx , glm::vec2 const& ddy ) const;
+		// color of texture coordinate tex, each channel in [0,255]
+		glm::vec3 GetColor ( const glm::vec2& tex , float lod = 0.0f ) const;
+		// GetColor for count texture coordinates sharing one level of detail,
+		// 8 at a time with AVX2 and 4 with SSE2
+		void GetColors ( glm::vec2 const* tex , glm::vec3* colors , int count , float lod = 0.0f ) const;
+
+		// texel ( x , y ) of a level with the wrap mode applied
+		Color Fetch ( Level const& level , int x , int y ) const;
+		// texel at index of the tiled layout, decoded if the texture is compressed
+		Color Texel ( size_t index ) const;
+		// the 16 texels of compressed tile block
+		void DecodeBlock ( size_t block , Color* texels ) const;
+		// filtered sample of one level
+		glm::vec3 Sample ( Level const& level , glm::vec2 const& tex ) const;
+		void Sample ( Level const& level , glm::vec2 const* tex , glm::vec3* colors , int count ) const;
+
+		std::vector<Level> levels;
+		// all levels, over-allocated so that the first tile starts on a cache line
+		std::vector<Color> storage;
+		// all levels of a compressed texture, one 64 bit word per bc1 block and
+		// two per bc3 block, the alpha block followed by the color block
+		std::vector<std::uint64_t> blocks;
+		// tells the per-thread caches of decoded blocks apart from those of
+		// earlier compressions
+		unsigned int blocks_id{};
+		// decoded blocks each thread keeps, direct mapped by block index
+		static constexpr int cache_blocks = 64;
 	};
 
 	static Model model_data;
 	static std::vector <std::pair< std::string , Model>> all_model_data ;
 	static void viewport_transform ( Model& model_transfrom );
-	static bool render_triangle_wireframe ( glm::vec3 p0 , glm::vec3 p1 , glm::vec3  p2 , GLPbo::Color clr );
-	static bool render_triangle ( glm::vec3 p0 , glm::vec3 p1 , glm::vec3  p2 , GLPbo::Color clr );
-	static bool render_triangle ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , glm::vec3 const& c0 , glm::vec3 const& c1 , glm::vec3 const& c2 );
-	static bool render_texture ( glm::vec3 p0 , glm::vec3 p1 , glm::vec3  p2 , glm::vec2 texture0, glm::vec2 texture1 , glm::vec2 texture2 );
-	static bool render_shadow_map ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 );
-	static bool render_point_light ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Model& model , int index0, int index1, int index2 );
-	static bool render_texture_point_light ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Model& model , int index0 , int index1 , int index2 , glm::vec2 texture0 , glm::vec2 texture1 , glm::vec2 texture2 );
-	static bool render_faceted ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Model& model , int index0 , int index1 , int index2 );
-	static bool render_texture_faceted ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Model& model , int index0 , int index1 , int index2 , glm::vec2 texture0 , glm::vec2 texture1 , glm::vec2 texture2 );
-
-
-	static glm::vec3 EdgeEqnTopLeft ( glm::vec3 const& p0 , glm::vec3 const& p1 );
-	static bool PointInEdgeTopLeftOptimized ( float edge_equation , glm::vec3 arbitrary_point , glm::vec2 increment , bool& top_left );
-	static bool PointInTriangleOptimized ( float const& e0 , float const& e1 , float const& e2 , glm::vec3 const& arbitrary_point , glm::vec2 increment , bool& top_left_e0 , bool& top_left_e1 , bool& top_left_e2 );
-	static float EvaluateFragment ( glm::vec3 evaluate_point , glm::vec3 const& arbitrary_point , bool& topleft );
+
+	// vertex stage, transforms vertex_batch vertices per job
+	static constexpr int vertex_batch = 4096;
+	static void prepare_vertices ( Model& model );
+	static void transform_vertices ( Model& model , size_t begin , size_t end , glm::mat3 const& rotation , glm::vec3 const& scale , glm::vec3 const& offset );
+
+	// load-time mesh optimizer. Reorders Model::tri for post-transform vertex
+	// cache reuse ( Forsyth ) and then the vertex arrays in order of first use
+	static void optimize_mesh ( Model& model , std::string const& name );
+	// average cache miss ratio, vertices transformed per triangle with a FIFO
+	// post-transform cache of acmr_cache_size entries
+	static constexpr int acmr_cache_size = 16;
+	static float acmr ( std::vector<unsigned short> const& tri , size_t vertex_cnt );
+
+	// load-time meshlet builder, cuts Model::tri in its current order into
+	// meshlets of at most meshlet_vertices vertices and meshlet_triangles triangles
+	static constexpr int meshlet_vertices = 64;
+	static constexpr int meshlet_triangles = 124;
+	// widens every normal cone, a triangle facing away by less than this can
+	// still snap to a positive area on the sub-pixel grid
+	static constexpr float cone_margin = 0.05f;
+	static void build_meshlets ( Model& model , std::string const& name );
+	// load-time edge list, edges shared by two triangles are drawn only once
+	static void build_edges ( Model& model , std::string const& name );
+	// rejects the meshlets that are off-screen or face away as a whole
+	static void cull_meshlets ( Model& model , glm::mat3 const& rotation , glm::vec3 const& scale , glm::vec3 const& offset );
+
+	// load-time level of detail chains. all_model_lods[ i ] holds up to
+	// lod_levels simplified versions of all_model_data[ i ], each with about
+	// half the triangles of the one before. Per frame the coarsest level whose
+	// error projects to at most lod_pixel_error pixels is drawn
+	static constexpr int lod_levels = 4;
+	static constexpr size_t lod_min_triangles = 256;
+	static constexpr float lod_pixel_error = 0.5f;
+	// weight of the normal and uv difference in the cost of an edge collapse
+	static constexpr float lod_attribute_weight = 0.01f;
+	static std::vector<std::vector<Model>> all_model_lods;
+	static void build_lods ( Model const& model , std::string const& name , std::vector<Model>& lods );
+	static Model& select_lod ( int index );
+
+	struct Varyings
+		/*! per-fragment inputs handed to a fragment shader by rasterize */
+	{
+		int x , y;          // window coordinates of the fragment
+		float b0 , b1 , b2; // barycentric coordinates
+		float z;            // interpolated window z
+		// change of b0 , b1 , b2 from one pixel to the next in x and in y. The
+		// projection is affine, so these are constant over a triangle and equal
+		// to the differences across a 2x2 quad of fragments
+		glm::vec3 ddx , ddy;
+
+		// barycentric interpolation of a per-vertex attribute
+		template < typename T >
+		T interpolate ( T const& a0 , T const& a1 , T const& a2 ) const
+		{
+			return b0 * a0 + b1 * a1 + b2 * a2;
+		}
+
+		// screen-space derivatives of an interpolated attribute
+		template < typename T >
+		T dx ( T const& a0 , T const& a1 , T const& a2 ) const
+		{
+			return ddx.x * a0 + ddx.y * a1 + ddx.z * a2;
+		}
+		template < typename T >
+		T dy ( T const& a0 , T const& a1 , T const& a2 ) const
+		{
+			return ddy.x * a0 + ddy.y * a1 + ddy.z * a2;
+		}
+	};
+
+	// derivatives of the barycentric coordinates of triangle p0 , p1 , p2 in x and y
+	static void BarycentricDerivatives ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , glm::vec3& ddx , glm::vec3& ddy );
+
+	// triangle pipeline shared by every filled render mode. Shader is a functor
+	// returning the Color of a fragment from its Varyings; its static constexpr
+	// bools depth_test and color_write select whether the fragment is depth
+	// tested and whether the returned Color is written to the PBO
+	template < typename Shader >
+	static bool rasterize ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Shader const& shader , glm::mat3 const* to_parent = nullptr );
+	// rasterizes the triangles of a tile bin, Shader is constructed per triangle
+	// from the model and the triangle's indices
+	template < typename Shader >
+	static void render_bin ( std::vector<GLuint> const& bin , Model const& model );
+
+
+	static bool PointInEdgeTopLeftOptimized ( std::int64_t edge_equation , bool top_left );
+	static bool PointInTriangleOptimized ( std::int64_t e0 , std::int64_t e1 , std::int64_t e2 , bool top_left_e0 , bool top_left_e1 , bool top_left_e2 );
 
 	static void line_bresenham_octant0347 ( int x1 , int y1 , int x2 , int y2 , Color clr );
 	static void line_bresenham_octant1256 ( GLint x1 , GLint y1 , GLint x2 , GLint y2 , GLPbo::Color draw_clr );
+
+	// number of adjacent fragments tested by one call to CoverageMask
+#if defined( GLPBO_AVX2 )
+	static constexpr int coverage_lanes = 8;
+#else
+	static constexpr int coverage_lanes = 4;
+#endif
+
+	struct Rect
+		/*! half-open window-space rectangle [x0, x1) x [y0, y1) */
+	{
+		GLint x0 , y0 , x1 , y1;
+	};
+
+	// window coordinates are snapped to 1 / subpixel_one of a pixel before
+	// rasterization ( 28.4 fixed point with the default of 4 bits )
+	static constexpr int subpixel_bits = 4;
+	static constexpr std::int64_t subpixel_one = std::int64_t ( 1 ) << subpixel_bits;
+
+	// side of the square blocks the bounding box is walked in. Must be a
+	// multiple of coverage_lanes so that spans never straddle two blocks
+	static constexpr int block_size = 8;
+	static_assert( block_size % coverage_lanes == 0 , "block_size must be a multiple of coverage_lanes" );
+
+	enum class BlockCoverage
+		/*! result of testing a block against the three edges */
+	{
+		outside ,   // no fragment of the block can be covered
+		partial ,   // some edge crosses the block, fragments need testing
+		inside      // every fragment of the block is covered
+	};
+
+	struct Edges
+		/*! the three edge functions of a triangle in fixed point. Edge i runs
+		from vertex ( i + 1 ) % 3 to vertex ( i + 2 ) % 3, i.e. it is opposite
+		vertex i. Values are exact integers, so stepping them across the
+		bounding box gives the same result as evaluating every fragment.
+		*/
+	{
+		std::int64_t step_x[ 3 ];   // change of the edge function per pixel in x
+		std::int64_t step_y[ 3 ];   // change of the edge function per pixel in y
+		std::int64_t origin[ 3 ];   // edge function at the center of pixel ( 0 , 0 )
+		std::int64_t bias[ 3 ];     // 0 for top-left edges, 1 otherwise
+		alignas( 32 ) std::int64_t lane_offset[ 3 ][ coverage_lanes ]; // lane * step_x
+		std::int64_t block_min[ 3 ]; // smallest change of the edge function over a block
+		std::int64_t block_max[ 3 ]; // largest change of the edge function over a block
+		std::int64_t area;          // twice the area, sum of the edge functions
+		Rect bounds;                // pixels whose centers may be covered
+	};
+
+	static std::int64_t SnapToSubpixel ( float v );
+	static bool SetupEdges ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Edges& edges );
+	static std::int64_t EvaluateFragment ( Edges const& edges , int edge , GLint x , GLint y );
+	static BlockCoverage ClassifyBlock ( Edges const& edges , std::int64_t const* corner );
+	static unsigned int CoverageMask ( Edges const& edges , std::int64_t* span , std::int64_t* e0 , std::int64_t* e1 , std::int64_t* e2 , bool trivial_accept );
+	static unsigned int SpanMask ( int remaining );
+	static int LowestLane ( unsigned int mask );
+
+	// multisampling, up to max_samples samples per pixel at fixed positions on
+	// the sub-pixel grid. rasterize hands color-writing shaders to
+	// rasterize_multisample while the frame is multisampled, which tests and
+	// depth tests every sample but shades a pixel only once per triangle,
+	// storing the color in the samples that passed. store_tile then
+	// averages the samples of a tile into the PBO
+	static constexpr int max_samples = 8;
+	template < typename Shader >
+	static bool rasterize_multisample ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Edges const& edges , Shader const& shader , glm::mat3 const* to_parent , glm::vec3 const& ddx , glm::vec3 const& ddy );
 	static void set_pixel ( int x , int y , Color clr );
-	static void set_pixel ( int x , int y , float z , Color clr );
 	// set all pixels with same color draw_clr on line segment starting
 	// at point P1(x1, y1) and ending at point P2(x2, y2)
 	// Note: points are in window coordinates
 	static void render_linebresenham ( GLint px0 , GLint py0 , GLint px1 , GLint py1 , GLPbo::Color draw_clr );
-	static void clear_depth_buffer ();
+
+	// --- tile-binned rasterization ---
+
+	struct ThreadPool
+		/*! persistent worker threads that share the jobs of a parallel_for.
+		The calling thread always takes part as worker 0, so a pool with a
+		single active thread runs every job in order on the caller.
+		*/
+	{
+		~ThreadPool ();
+		void start ( unsigned int count );
+		void stop ();
+		// run fn ( index , worker ) for every index in [0, count) and
+		// return once all of them are done
+		void parallel_for ( int count , std::function<void ( int , int )> const& fn );
+		// number of threads (including the caller) used by parallel_for
+		void set_active ( unsigned int count );
+		unsigned int active () const { return active_cnt; }
+		unsigned int size () const { return static_cast< unsigned int >( workers.size () ) + 1; }
+
+	private:
+		void worker_loop ( unsigned int id );
+		void run_jobs ( unsigned int id );
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable cv_work , cv_done;
+		std::function<void ( int , int )> const* job{ nullptr };
+		std::atomic<int> next_job{ 0 };
+		int job_cnt{ 0 };
+		unsigned int pending{ 0 };
+		unsigned int generation{ 0 };
+		unsigned int active_cnt{ 1 };
+		bool quit{ false };
+	};
+
+	static ThreadPool thread_pool;
+
+#if defined( GLPBO_TRACE )
+	struct Trace
+		/*! timing markers on the stages of a frame. Every thread records its
+		own track, and the frames of a recording are written as a
+		chrome://tracing / Perfetto JSON file. Mark a stage with
+		GLPBO_TRACE_SCOPE, which compiles to nothing without GLPBO_TRACE.
+		*/
+	{
+		// times the rest of the enclosing block while a recording runs
+		struct Scope
+		{
+			explicit Scope ( char const* name );
+			~Scope ();
+			char const* name;
+			std::int64_t start;
+		};
+		// records the next frames frames and writes them to file
+		static void start ( std::string const& file , int frames );
+		// called as a frame starts, begins or ends the recording
+		static void next_frame ();
+		// writes the frames recorded so far and ends the recording
+		static void finish ();
+	};
+#endif
+
+	// screen is split into tile_size x tile_size tiles, each tile owns the list
+	// of front-facing triangles (as offsets into Model::tri) that overlap it
+	static constexpr GLint tile_size = 64;
+	static GLint tile_cols , tile_rows;
+	static std::vector<std::vector<GLuint>> tile_bins;
+	// sizes the tile lists and buffers for width x height
+	static void setup_tiles ();
+	// lights reaching each tile, as indices into the light list
+	static std::vector<std::vector<GLuint>> tile_lights;
+	static void assign_lights ();
+	// keeps the key light and adds count - 1 small coloured lights around the model
+	static void set_light_count ( size_t count );
+
+	// culling pre-pass. Streams the triangles of the visible meshlets in jobs
+	// of cull_batch triangles and keeps the ones that are neither entirely
+	// outside the viewport nor back-facing, in submission order
+	static constexpr int cull_batch = 4096;
+	static std::vector<GLuint> visible_triangles;
+	static void cull_triangles ( Model const& model );
+	static unsigned int cull_range ( Model const& model , size_t begin , size_t end , std::vector<GLuint>& visible );
+
+	static void bin_triangles ( Model const& model );
+	static void bin_bounds ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , GLuint entry );
+	// the wireframe mode bins lines instead, indices into lines of the edges
+	// with a visible triangle on either side, in window coordinates
+	struct Line { GLint x0 , y0 , x1 , y1; };
+	static std::vector<Line> lines;
+	static void bin_edges ( Model const& model );
+	static void render_tile ( int tile , Model& model );
+
+	struct Framebuffer
+		/*! color and depth of the window kept tile by tile. Every tile is one
+		block of tile_size x tile_size pixels, row by row, each pixel samples
+		colors and depths in a row. Clearing only flags the tiles: a tile is
+		filled with the clear values when it is first rendered to, and one
+		that never is goes to the PBO as the clear color by store_tile.
+		*/
+	{
+		std::vector<Color> color;
+		std::vector<float> depth;
+		// per tile, whether it counts as cleared and its contents are stale
+		std::vector<std::uint8_t> cleared;
+		int samples{ 1 };
+
+		// allocates tiles tiles of samples samples per pixel, all cleared
+		void Resize ( int tiles , int samples );
+		// flags every tile as cleared
+		void Clear ();
+		// fills tile with the clear values if it is flagged as cleared
+		void Touch ( int tile );
+
+		// index of the first sample of pixel ( x , y ) in color and depth
+		size_t Index ( int x , int y ) const
+		{
+			unsigned int ux = static_cast< unsigned int >( x ) , uy = static_cast< unsigned int >( y );
+			size_t tile = static_cast< size_t >( uy / tile_size ) * tile_cols + ux / tile_size;
+			return ( ( tile * tile_size + uy % tile_size ) * tile_size + ux % tile_size ) * samples;
+		}
+	};
+	// writes a tile of the framebuffer to the PBO, averaging its samples
+	static void store_tile ( int tile );
+
+	// --- PBO write kernels ---
+
+	// fill and copy of Colors, which is all that is ever written to the PBO.
+	// Mapped PBO memory is usually write-combined, so the streaming variants
+	// that bypass the cache tend to win. select_kernels times every variant
+	// built for this machine once at startup, on the tile rows store_tile
+	// writes, and keeps the fastest
+	enum class Kernel { scalar , sse2_stream , avx_stream };
+	static void fill_colors ( Color* dst , size_t count , Color clr );
+	static void copy_colors ( Color* dst , Color const* src , size_t count );
+	static void select_kernels ();
+
+	// --- clipper ---
+
+	// triangles are rasterized unclipped as long as they stay within
+	// guard_band pixels of the viewport, which keeps the fixed-point edge
+	// functions far from overflowing. Larger ones are clipped against the band.
+	static constexpr float guard_band = 8192.0f;
+
+	struct ClippedTriangle
+		/*! one triangle of the fan a clipped triangle is split into */
+	{
+		glm::vec3 p[ 3 ];      // window coordinates
+		glm::mat3 to_parent;   // column i holds the barycentrics of p[ i ] in the original triangle
+		GLuint parent;         // offset into Model::tri of the original triangle
+	};
+
+	// bin entries with clipped_bit set index clipped_triangles instead of Model::tri
+	static constexpr GLuint clipped_bit = 0x80000000u;
+	static std::vector<ClippedTriangle> clipped_triangles;
+
+	static void clip_triangle ( Model const& model , GLuint offset );
+
+	// --- visibility buffer ( deferred shading ) ---
+
+	struct VisibilitySample
+		/*! what the first pass of the visibility buffer mode keeps per pixel,
+		depth is kept in the framebuffer as usual */
+	{
+		GLuint triangle;    // offset into Model::tri, no_triangle if uncovered
+		float b0 , b1 , b2; // barycentric coordinates of the pixel center
+	};
+	static constexpr GLuint no_triangle = ~0u;
+
+	// second pass of the visibility buffer mode, shades every covered pixel
+	// of the calling thread's tile exactly once
+	template < typename Shader >
+	static void resolve_tile ( Model const& model );
 
 };
 
+#if defined( GLPBO_TRACE )
+#define GLPBO_TRACE_JOIN2( a , b ) a##b
+#define GLPBO_TRACE_JOIN( a , b ) GLPBO_TRACE_JOIN2( a , b )
+#define GLPBO_TRACE_SCOPE( name ) GLPbo::Trace::Scope const GLPBO_TRACE_JOIN( trace_scope_ , __LINE__ ){ name }
+#else
+#define GLPBO_TRACE_SCOPE( name )
+#endif
+
 #endif /* GLPBO_H */
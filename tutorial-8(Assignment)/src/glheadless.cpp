@@ -0,0 +1,92 @@
+/*!
+@file    glheadless.cpp
+@author  Jia Min / j.jiamin@digipen.edu
+@date    17/10/2026
+
+This file implements the GLHelper of the headless build, which stands in
+for the window and OpenGL context of glhelper.cpp when GLPbo is built with
+GLPBO_HEADLESS.
+
+*//*__________________________________________________________________________*/
+
+/*                                                                   includes
+----------------------------------------------------------------------------- */
+#include <glheadless.h>
+#include <chrono>
+#include <thread>
+
+/*                                                   objects with file scope
+----------------------------------------------------------------------------- */
+// static data members declared in GLHelper
+GLint GLHelper::width;
+GLint GLHelper::height;
+GLdouble GLHelper::fps;
+std::string GLHelper::title;
+std::string GLHelper::status;
+GLdouble GLHelper::time = 0.0;
+GLdouble GLHelper::frame_time = 1.0 / 60.0;
+GLboolean GLHelper::mouseLeft = GL_FALSE;
+GLboolean GLHelper::keystateA = GL_FALSE;
+GLboolean GLHelper::keystateC = GL_FALSE;
+GLboolean GLHelper::keystateH = GL_FALSE;
+GLboolean GLHelper::keystateK = GL_FALSE;
+GLboolean GLHelper::keystateM = GL_FALSE;
+GLboolean GLHelper::keystateR = GL_FALSE;
+GLboolean GLHelper::keystateT = GL_FALSE;
+GLboolean GLHelper::keystateU = GL_FALSE;
+GLboolean GLHelper::keystateV = GL_FALSE;
+GLboolean GLHelper::keystateW = GL_FALSE;
+GLboolean GLHelper::keystateZ = GL_FALSE;
+
+/*  _________________________________________________________________________*/
+/*! update_time
+
+@param double
+fps_calc_interval: the interval (in seconds) at which fps is to be
+calculated
+
+@return double
+Return time interval (in seconds) between previous and current frames,
+always frame_time
+
+Advances GLHelper::time by frame_time, so that animation does not depend on
+how fast frames are rendered. fps is still measured on the wall clock every
+"fps_calc_interval" seconds.
+*/
+double GLHelper::update_time ( double fps_calc_interval )
+{
+	GLHelper::time += frame_time;
+
+	// fps calculations
+	static double count = 0.0; // number of game loop iterations
+	static std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now ();
+	std::chrono::steady_clock::time_point curr_time = std::chrono::steady_clock::now ();
+	// get elapsed time since the last measurement (in seconds) ...
+	double elapsed_time = std::chrono::duration<double> ( curr_time - start_time ).count ();
+
+	++count;
+
+	// update fps at least every 10 seconds ...
+	fps_calc_interval = ( fps_calc_interval < 0.0 ) ? 0.0 : fps_calc_interval;
+	fps_calc_interval = ( fps_calc_interval > 10.0 ) ? 10.0 : fps_calc_interval;
+	if( elapsed_time > fps_calc_interval )
+	{
+		GLHelper::fps = count / elapsed_time;
+		start_time = curr_time;
+		count = 0.0;
+	}
+
+	return frame_time;
+}
+
+/*  _________________________________________________________________________*/
+/*! print_specs
+
+Prints what renders the frames in place of the GL specs.
+*/
+void GLHelper::print_specs ()
+{
+	std::cout << "GL Renderer : none , headless" << std::endl;
+	std::cout << "Hardware Threads : " << std::thread::hardware_concurrency () << std::endl;
+	std::cout << "Frame Size : " << width << " x " << height << std::endl;
+}
@@ -27,6 +27,7 @@ std::string GLHelper::title;
 GLFWwindow* GLHelper::ptr_window;
 GLboolean GLHelper::mouseLeft = GL_FALSE;
 GLboolean GLHelper::keystateA = GL_FALSE;
+GLboolean GLHelper::keystateC = GL_FALSE;
 GLboolean GLHelper::keystateH = GL_FALSE;
 GLboolean GLHelper::keystateK = GL_FALSE;
 GLboolean GLHelper::keystateM = GL_FALSE;
@@ -205,6 +206,7 @@ void GLHelper::key_cb ( GLFWwindow* pwin , int key , int scancode , int action ,
 		keystateT = ( key == GLFW_KEY_T ) ? GL_TRUE : GL_FALSE;
 		keystateM = ( key == GLFW_KEY_M ) ? GL_TRUE : GL_FALSE;
 		keystateA = ( key == GLFW_KEY_A ) ? GL_TRUE : GL_FALSE;
+		keystateC = ( key == GLFW_KEY_C ) ? GL_TRUE : GL_FALSE;
 		keystateR = ( key == GLFW_KEY_R ) ? GL_TRUE : GL_FALSE;
 		keystateW = ( key == GLFW_KEY_W ) ? GL_TRUE : GL_FALSE;
 	}
@@ -215,6 +217,7 @@ void GLHelper::key_cb ( GLFWwindow* pwin , int key , int scancode , int action ,
 		keystateT = GL_FALSE;
 		keystateM = GL_FALSE;
 		keystateA = GL_FALSE;
+		keystateC = GL_FALSE;
 		keystateR = GL_FALSE;
 		keystateW = GL_FALSE;
 
@@ -230,6 +233,7 @@ void GLHelper::key_cb ( GLFWwindow* pwin , int key , int scancode , int action ,
 		keystateT = GL_FALSE;
 		keystateM = GL_FALSE;
 		keystateA = GL_FALSE;
+		keystateC = GL_FALSE;
 		keystateW = GL_FALSE;
 		keystateR = GL_FALSE;
 	}
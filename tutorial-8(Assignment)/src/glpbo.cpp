@@ -17,10 +17,17 @@ emulator executed on the CPU for display by the GPU.
 #include <random>
 #include <iomanip>
 #include <cmath>
+#include <memory>
+#include <new>
+#include <type_traits>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
 
 /* Debugging tool
 ----------------------------------------------------------------------------- */
 
+#if !defined( GLPBO_HEADLESS )
 #define ASSERT(x) if (!(x)) __debugbreak();
 #define GLCall(x) GLClearError();\
 	x;\
@@ -60,6 +67,7 @@ bool GLLogCall ( const char* function , const char* file , int line )
 	}
 	return true;
 }
+#endif
 
 /* All static members
 ----------------------------------------------------------------------------- */
@@ -68,33 +76,116 @@ GLsizei GLPbo::height{};
 GLsizei GLPbo::pixel_cnt{};
 GLsizei GLPbo::byte_cnt{};
 GLPbo::Color* GLPbo::ptr_to_pbo{ nullptr };
+#if !defined( GLPBO_HEADLESS )
 GLuint GLPbo::vaoid{};
 GLuint GLPbo::elem_cnt{};
 GLuint GLPbo::pboid{};
 GLuint GLPbo::texid{};
 GLSLShader GLPbo::shdr_pgm{};
+#endif
 GLPbo::Color GLPbo::clear_clr{};
 GLPbo::Model GLPbo::model_data{};
+GLPbo::ThreadPool GLPbo::thread_pool{};
+GLint GLPbo::tile_cols{};
+GLint GLPbo::tile_rows{};
+std::vector < std::vector < GLuint > > GLPbo::tile_bins{};
+std::vector < std::vector < GLuint > > GLPbo::tile_lights{};
+std::vector < GLPbo::ClippedTriangle > GLPbo::clipped_triangles{};
+std::vector < GLuint > GLPbo::visible_triangles{};
+std::vector < GLPbo::Line > GLPbo::lines{};
 
 GLboolean	key_r_last = false;
 GLboolean	key_w_last = false;
 GLboolean	key_m_last = false;
-
-GLPbo::PointLight point_light{ {1.0f,1.0f,1.0f}, {0.0f,0.0f , 10.0f} };
+GLboolean	key_t_last = false;
+GLboolean	key_k_last = false;
+GLboolean	key_v_last = false;
+GLboolean	key_c_last = false;
+GLboolean	key_a_last = false;
+#if defined( GLPBO_TRACE )
+GLboolean	key_z_last = false;
+#endif
+
+// the first light is the key light, the rest only reach the tiles they
+// overlap. Button K cycles through light_counts of them
+std::vector < GLPbo::PointLight > point_lights{ { { 1.0f , 1.0f , 1.0f } , { 0.0f , 0.0f , 10.0f } , { 0.0f , 0.0f , 10.0f } , 0.0f } };
+size_t const light_counts[] = { 1 , 16 , 64 , 256 };
+int light_count_index = 0;
 
 std::vector < std::pair < std::string , GLPbo::Model>> GLPbo::all_model_data{};
-
-std::vector < float > depth_buffer{};
+std::vector < std::vector < GLPbo::Model > > GLPbo::all_model_lods{};
+
+// color and depth of the frame being rendered, stored to the PBO tile by tile
+GLPbo::Framebuffer framebuffer{};
+
+#if defined( GLPBO_HEADLESS )
+// the frames of the headless build are kept in memory starting on a cache
+// line, like a mapped PBO
+std::align_val_t const frame_alignment{ 64 };
+#endif
+
+// PBO write kernels picked by GLPbo::select_kernels
+#if defined( GLPBO_AVX2 )
+int const kernel_cnt = 3;
+#elif defined( GLPBO_SSE2 )
+int const kernel_cnt = 2;
+#else
+int const kernel_cnt = 1;
+#endif
+GLPbo::Kernel fill_kernel = GLPbo::Kernel::scalar;
+GLPbo::Kernel copy_kernel = GLPbo::Kernel::scalar;
+
+// Button A cycles the filled modes through sample_counts samples per pixel
+int const sample_counts[] = { 1 , 4 , 8 };
+int sample_count_index = 0;
+// sample positions from the pixel center in 1 / subpixel_one of a pixel,
+// the usual rotated patterns so that no two samples share a row or column
+static_assert( GLPbo::subpixel_one == 16 , "the sample patterns are in 1/16 of a pixel" );
+int const sample_pattern_4[ 4 ][ 2 ] = { { -2 , -6 } , { 6 , -2 } , { -6 , 2 } , { 2 , 6 } };
+int const sample_pattern_8[ 8 ][ 2 ] = { { 1 , -3 } , { -1 , 3 } , { 5 , 1 } , { -3 , -5 } , { -5 , 5 } , { -7 , -1 } , { 3 , 7 } , { 7 , -7 } };
+
+// nearest triangle of every pixel, only filled in Mode::visibility_buffer
+std::vector < GLPbo::VisibilitySample > visibility_buffer{};
+
+// scratch of GLPbo::viewport_transform, kept between frames so that the
+// vertex stage does not allocate : per meshlet whether its vertices are
+// needed, and the vertex ranges of the transform jobs
+std::vector < char > meshlet_needed{};
+std::vector < std::pair < size_t , size_t > > vertex_ranges{};
+
+// scratch of GLPbo::cull_triangles : the triangle ranges of the cull jobs,
+// and what each job kept and how many it culled
+std::vector < std::pair < size_t , size_t > > cull_ranges{};
+std::vector < std::vector < GLuint > > batch_visible{};
+std::vector < unsigned int > batch_culled{};
+
+// scratch of GLPbo::bin_edges : per triangle, whether it is in visible_triangles
+std::vector < std::uint8_t > triangle_visible{};
 
 GLPbo::Texture texture{};
+char const* const texture_file = "../images/ogre.tex";
 
 bool rotate = false;
 double rotation_angle = 3.142;
 int current_model = 0;
-
-unsigned int vertices_;
-unsigned int triangle_;
-unsigned int culled_;
+// level of detail drawn, 0 is the model itself
+int lod_level = 0;
+
+// counters of the frame emulate () rendered last
+GLPbo::PipelineStatistics frame_statistics{};
+// counters of one thread for the frame being rendered. A triangle spans
+// several tiles, so the pixels it covered are added up per triangle, indexed
+// by its offset into Model::tri / 3, and only bucketed once the frame is done
+struct ThreadCounters
+{
+	GLPbo::PipelineStatistics statistics;
+	std::vector<unsigned int> triangle_pixels;
+};
+// counters of every thread, kept for the life of the program so that a
+// thread only ever touches its own
+std::mutex statistics_mutex;
+std::vector<std::unique_ptr<ThreadCounters>> thread_counters_list;
+thread_local ThreadCounters* thread_counters{ nullptr };
 
 enum class Mode
 {
@@ -108,18 +199,416 @@ enum class Mode
 	texture ,
 	texture_faceted,
 	texture_point_light ,
+	visibility_buffer ,
 	Count
 };
 
 Mode mode = Mode::wireframe_black;
+// shown in the window title, in the order of Mode
+char const* const mode_names[] = { "Wireframe Black" , "ShadowMap" , "PointLight" , "Faceted" , "Texture" , "TextureFaceted" , "TexturePointLight" , "VisibilityBuffer" };
+static_assert( sizeof ( mode_names ) / sizeof ( mode_names[ 0 ] ) == static_cast< size_t >( Mode::Count ) , "every mode needs a name" );
+
+// region of the framebuffer the calling thread is allowed to write to
+thread_local GLPbo::Rect scissor{};
+
+// tile the calling thread renders, selects its list in GLPbo::tile_lights
+thread_local int current_tile{};
+
+// offset into Model::tri of the triangle the calling thread rasterizes, the
+// one CountFragments adds the covered pixels to
+thread_local GLuint current_triangle{};
+
+// blocks of a compressed texture the calling thread decoded last, see
+// GLPbo::Texture::Texel
+struct BlockCache
+{
+	unsigned int blocks_id{};
+	size_t tag[ GLPbo::Texture::cache_blocks ];
+	GLPbo::Color texels[ GLPbo::Texture::cache_blocks ][ 16 ];
+};
+thread_local BlockCache block_cache{};
+
+#if defined( GLPBO_TRACE )
+// button Z records this many frames to trace_default_file
+int const trace_frames = 10;
+char const* const trace_default_file = "trace.json";
+
+// a complete event of the trace, in nanoseconds since trace_epoch
+struct TraceEvent
+{
+	char const* name;
+	std::int64_t start , duration;
+};
+// events of one thread, tid is its track in the trace. Buffers are kept for
+// the life of the program so that no thread waits on another to record
+struct TraceBuffer
+{
+	int tid;
+	std::vector<TraceEvent> events;
+};
+std::mutex trace_mutex;
+std::vector<std::unique_ptr<TraceBuffer>> trace_buffers;
+thread_local TraceBuffer* trace_buffer{ nullptr };
+std::atomic<bool> trace_recording{ false };
+int trace_frames_left = 0;
+std::string trace_file;
+std::chrono::steady_clock::time_point const trace_epoch = std::chrono::steady_clock::now ();
+#endif
 
 /* All functions
 ----------------------------------------------------------------------------- */
 
+/**
+ * @brief
+ * counters of the calling thread, created the first time the thread counts
+*/
+ThreadCounters& ThreadLocalCounters ()
+{
+	if( !thread_counters )
+	{
+		std::lock_guard<std::mutex> lock ( statistics_mutex );
+		thread_counters_list.emplace_back ( new ThreadCounters{} );
+		thread_counters = thread_counters_list.back ().get ();
+	}
+	return *thread_counters;
+}
+
+/**
+ * @brief
+ * pipeline counters of the calling thread
+*/
+GLPbo::PipelineStatistics& ThreadStatistics ()
+{
+	return ThreadLocalCounters ().statistics;
+}
+
+/**
+ * @brief
+ * bucket of PipelineStatistics::pixels_per_triangle for a pixel count
+*/
+int HistogramBucket ( unsigned int pixels )
+{
+	int bucket = 0;
+	for( ; pixels && bucket + 1 < GLPbo::PipelineStatistics::histogram_buckets ; pixels >>= 1 )
+	{
+		++bucket;
+	}
+	return bucket;
+}
+
+/**
+ * @brief
+ * adds what rasterize counted for current_triangle in a tile to the
+ * counters of the calling thread
+ * @param tested
+ * pixels whose coverage was tested
+ * @param covered
+ * pixels the triangle covered
+ * @param occluded
+ * covered pixels that failed the depth test
+*/
+template < typename Shader >
+void CountFragments ( unsigned int tested , unsigned int covered , unsigned int occluded )
+{
+	ThreadCounters& counters = ThreadLocalCounters ();
+	GLPbo::PipelineStatistics& statistics = counters.statistics;
+	statistics.pixels += tested;
+	if( Shader::depth_test )
+	{
+		statistics.depth_passed += covered - occluded;
+		statistics.depth_failed += occluded;
+	}
+	// the first pass of the visibility buffer only records the triangle,
+	// resolve_tile shades the pixel later
+	if( Shader::color_write )
+	{
+		statistics.fragments += covered - occluded;
+		statistics.texture_samples += static_cast< std::uint64_t >( covered - occluded ) * Shader::texture_samples;
+	}
+	GLuint triangle = current_triangle / 3;
+	if( counters.triangle_pixels.size () <= triangle )
+	{
+		counters.triangle_pixels.resize ( triangle + 1 );
+	}
+	counters.triangle_pixels[ triangle ] += covered;
+}
+
+
+/**
+ * @brief
+ * diffuse light at a point from the lights assigned to the current tile
+ * @param tri_point , normal
+ * point and its normal in model space, the normal need not be unit length
+ * @return
+ * light of every color channel, saturated at 1
+*/
+glm::vec3 Calculate_Light ( glm::vec3 const& tri_point , glm::vec3 const& normal )
+{
+	glm::vec3 unit_normal = glm::normalize ( normal );
+	glm::vec3 light{ 0.0f };
+	for( GLuint l : GLPbo::tile_lights[ current_tile ] )
+	{
+		GLPbo::PointLight const& point_light = point_lights[ l ];
+		glm::vec3 to_light = point_light.transform_position - tri_point;
+		float attenuation = 1.0f;
+		if( point_light.radius > 0.0f )
+		{
+			// smooth falloff that reaches 0 at radius
+			float falloff = 1.0f - glm::dot ( to_light , to_light ) / ( point_light.radius * point_light.radius );
+			if( falloff <= 0.0f )
+			{
+				continue;
+			}
+			attenuation = falloff * falloff;
+		}
+		light += point_light.intensity * ( std::max ( 0.0f , glm::dot ( glm::normalize ( to_light ) , unit_normal ) ) * attenuation );
+	}
+	return glm::min ( light , glm::vec3{ 1.0f } );
+}
+
+/* Fragment shaders
+-----------------------------------------------------------------------------
+Each filled render mode is a functor handed to GLPbo::rasterize. It gathers
+what it needs from the triangle once when constructed and returns the color
+of a fragment from its Varyings. depth_test selects whether rasterize depth
+tests the fragment first, color_write whether the color goes to the PBO,
+texture_samples how many texture lookups the shader makes per fragment.
+Shaders that sample the texture also hand out its coordinate and level of
+detail, and take the sampled color as a second argument, so that ShadeRun
+can sample a run of fragments at once.
+----------------------------------------------------------------------------- */
+
+struct ShadowMapShader
+{
+	static constexpr bool depth_test = true;
+	static constexpr bool color_write = true;
+	static constexpr int texture_samples = 0;
+
+	ShadowMapShader ( GLPbo::Model const& , GLuint , GLuint , GLuint )
+	{}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v ) const
+	{
+		float z_value_invert = 1.0f - v.z;
+		return { static_cast< GLubyte >( z_value_invert * 255.0f ) , static_cast< GLubyte > ( z_value_invert * 255.0f ) ,static_cast< GLubyte >( z_value_invert * 255.0f ) , 255 };
+	}
+};
+
+struct PointLightShader
+{
+	static constexpr bool depth_test = true;
+	static constexpr bool color_write = true;
+	static constexpr int texture_samples = 0;
+	GLPbo::Model const& model;
+	GLuint index0 , index1 , index2;
+
+	PointLightShader ( GLPbo::Model const& m , GLuint i0 , GLuint i1 , GLuint i2 ) :
+		model ( m ) , index0 ( i0 ) , index1 ( i1 ) , index2 ( i2 )
+	{}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v ) const
+	{
+		glm::vec3 tri_point = v.interpolate ( model.pm[ index0 ] , model.pm[ index1 ] , model.pm[ index2 ] );
+		glm::vec3 tri_normal = v.interpolate ( model.nml[ index0 ] , model.nml[ index1 ] , model.nml[ index2 ] );
+		glm::vec3 light = Calculate_Light ( tri_point , tri_normal );
+		return { static_cast< GLubyte >( light.x * 255.0f ) , static_cast< GLubyte > ( light.y * 255.0f ) ,static_cast< GLubyte >( light.z * 255.0f ) , 255 };
+	}
+};
+
+struct FacetedShader
+{
+	static constexpr bool depth_test = true;
+	static constexpr bool color_write = true;
+	static constexpr int texture_samples = 0;
+	GLPbo::Model const& model;
+	GLuint index0 , index1 , index2;
+	glm::vec3 tri_normal;
+
+	FacetedShader ( GLPbo::Model const& m , GLuint i0 , GLuint i1 , GLuint i2 ) :
+		model ( m ) , index0 ( i0 ) , index1 ( i1 ) , index2 ( i2 ) ,
+		tri_normal ( glm::cross ( ( m.pm[ i1 ] - m.pm[ i0 ] ) , ( m.pm[ i2 ] - m.pm[ i0 ] ) ) )
+	{}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v ) const
+	{
+		glm::vec3 tri_point = v.interpolate ( model.pm[ index0 ] , model.pm[ index1 ] , model.pm[ index2 ] );
+		glm::vec3 light = Calculate_Light ( tri_point , tri_normal );
+		return { static_cast< GLubyte >( light.x * 255.0f ) , static_cast< GLubyte > ( light.y * 255.0f ) ,static_cast< GLubyte >( light.z * 255.0f ) , 255 };
+	}
+};
+
+struct TextureShader
+{
+	static constexpr bool depth_test = true;
+	static constexpr bool color_write = true;
+	static constexpr int texture_samples = 1;
+	glm::vec2 texture0 , texture1 , texture2;
+
+	TextureShader ( GLPbo::Model const& m , GLuint i0 , GLuint i1 , GLuint i2 ) :
+		texture0 ( m.tex[ i0 ] ) , texture1 ( m.tex[ i1 ] ) , texture2 ( m.tex[ i2 ] )
+	{}
+
+	glm::vec2 coordinate ( GLPbo::Varyings const& v ) const
+	{
+		return v.interpolate ( texture0 , texture1 , texture2 );
+	}
+
+	// level of detail of the triangle's footprint when the texture is
+	// mipmapped, the same for every fragment of the triangle
+	float lod ( GLPbo::Varyings const& v ) const
+	{
+		if( texture.mip_filter == GLPbo::Texture::MipFilter::none )
+		{
+			return 0.0f;
+		}
+		return texture.Lod ( v.dx ( texture0 , texture1 , texture2 ) , v.dy ( texture0 , texture1 , texture2 ) );
+	}
+
+	// texture color at the fragment
+	glm::vec3 sample ( GLPbo::Varyings const& v ) const
+	{
+		return texture.GetColor ( coordinate ( v ) , lod ( v ) );
+	}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& , glm::vec3 const& tex_color ) const
+	{
+		return { ( GLubyte ) tex_color.x , ( GLubyte ) tex_color.y , ( GLubyte ) tex_color.z , 255 };
+	}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v ) const
+	{
+		return ( *this ) ( v , sample ( v ) );
+	}
+};
+
+struct TexturePointLightShader
+{
+	static constexpr bool depth_test = true;
+	static constexpr bool color_write = true;
+	static constexpr int texture_samples = TextureShader::texture_samples;
+	PointLightShader lighting;
+	TextureShader texturing;
+
+	TexturePointLightShader ( GLPbo::Model const& m , GLuint i0 , GLuint i1 , GLuint i2 ) :
+		lighting ( m , i0 , i1 , i2 ) , texturing ( m , i0 , i1 , i2 )
+	{}
+
+	glm::vec2 coordinate ( GLPbo::Varyings const& v ) const
+	{
+		return texturing.coordinate ( v );
+	}
+
+	float lod ( GLPbo::Varyings const& v ) const
+	{
+		return texturing.lod ( v );
+	}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v ) const
+	{
+		return ( *this ) ( v , texturing.sample ( v ) );
+	}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v , glm::vec3 const& tex_color ) const
+	{
+		glm::vec3 tri_point = v.interpolate ( lighting.model.pm[ lighting.index0 ] , lighting.model.pm[ lighting.index1 ] , lighting.model.pm[ lighting.index2 ] );
+		glm::vec3 tri_normal = v.interpolate ( lighting.model.nml[ lighting.index0 ] , lighting.model.nml[ lighting.index1 ] , lighting.model.nml[ lighting.index2 ] );
+		glm::vec3 light = Calculate_Light ( tri_point , tri_normal );
+		return { static_cast< GLubyte >( light.x * tex_color.x ) , static_cast< GLubyte > ( light.y * tex_color.y ) ,static_cast< GLubyte >( light.z * tex_color.z ) , 255 };
+	}
+};
+
+struct TextureFacetedShader
+{
+	static constexpr bool depth_test = true;
+	static constexpr bool color_write = true;
+	static constexpr int texture_samples = TextureShader::texture_samples;
+	FacetedShader lighting;
+	TextureShader texturing;
+
+	TextureFacetedShader ( GLPbo::Model const& m , GLuint i0 , GLuint i1 , GLuint i2 ) :
+		lighting ( m , i0 , i1 , i2 ) , texturing ( m , i0 , i1 , i2 )
+	{}
+
+	glm::vec2 coordinate ( GLPbo::Varyings const& v ) const
+	{
+		return texturing.coordinate ( v );
+	}
+
+	float lod ( GLPbo::Varyings const& v ) const
+	{
+		return texturing.lod ( v );
+	}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v ) const
+	{
+		return ( *this ) ( v , texturing.sample ( v ) );
+	}
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v , glm::vec3 const& tex_color ) const
+	{
+		glm::vec3 tri_point = v.interpolate ( lighting.model.pm[ lighting.index0 ] , lighting.model.pm[ lighting.index1 ] , lighting.model.pm[ lighting.index2 ] );
+		glm::vec3 light = Calculate_Light ( tri_point , lighting.tri_normal );
+		return { static_cast< GLubyte >( light.x * tex_color.x ) , static_cast< GLubyte > ( light.y * tex_color.y ) ,static_cast< GLubyte >( light.z * tex_color.z ) , 255 };
+	}
+};
+
+// first pass of Mode::visibility_buffer, records which triangle is nearest
+struct VisibilityShader
+{
+	static constexpr bool depth_test = true;
+	static constexpr bool color_write = false;
+	static constexpr int texture_samples = 0;
+	GLuint triangle;
+
+	GLPbo::Color operator() ( GLPbo::Varyings const& v ) const
+	{
+		visibility_buffer[ v.y * GLPbo::width + v.x ] = { triangle , v.b0 , v.b1 , v.b2 };
+		return {};
+	}
+};
+
+/**
+ * @brief
+ * shades a run of fragments of one triangle with a shader that does not
+ * sample the texture
+ * @param shader
+ * shader of the triangle
+ * @param v
+ * varyings of the fragments
+ * @param count
+ * number of fragments, at most GLPbo::tile_size
+ * @param colors
+ * receives the color of every fragment
+*/
+template < typename Shader >
+void ShadeRun ( Shader const& shader , GLPbo::Varyings const* v , int count , GLPbo::Color* colors , std::false_type )
+{
+	for( int k = 0 ; k < count ; ++k )
+	{
+		colors[ k ] = shader ( v[ k ] );
+	}
+}
 
-float Calculate_Light ( GLPbo::PointLight light , glm::vec3 tri_point , glm::vec3 normal )
+/**
+ * @brief
+ * ShadeRun for a shader that samples the texture. The level of detail is
+ * the same for every fragment of a triangle, so the whole run is sampled
+ * by one Texture::GetColors, several fragments at a time
+*/
+template < typename Shader >
+void ShadeRun ( Shader const& shader , GLPbo::Varyings const* v , int count , GLPbo::Color* colors , std::true_type )
 {
-	return std::max ( 0.0f , glm::dot ( glm::normalize ( light.transform_position - tri_point ) , glm::normalize ( normal ) ) );
+	glm::vec2 tex[ GLPbo::tile_size ];
+	glm::vec3 tex_colors[ GLPbo::tile_size ];
+	for( int k = 0 ; k < count ; ++k )
+	{
+		tex[ k ] = shader.coordinate ( v[ k ] );
+	}
+	texture.GetColors ( tex , tex_colors , count , shader.lod ( v[ 0 ] ) );
+	for( int k = 0 ; k < count ; ++k )
+	{
+		colors[ k ] = shader ( v[ k ] , tex_colors[ k ] );
+	}
 }
 
 /**
@@ -131,70 +620,64 @@ float Calculate_Light ( GLPbo::PointLight light , glm::vec3 tri_point , glm::vec
 	Mode 3: render flat shaded triangles using randomly generated triangle color
 	Mode 4: render smooth shaded triangles by interpolating per-vertex normal coordinates
  * Button R : allows users to rotate the models' 2D coordinates (with respect to axis).
+ * Button T : toggles rendering between a single thread and all hardware threads.
+ * Button K : cycles the number of point lights through light_counts.
+ * Button V : cycles nearest , bilinear , bilinear from the nearest mip level and trilinear texture filtering.
+ * Button C : cycles the texture between uncompressed , bc1 and bc3 blocks.
+ * Button A : cycles the filled modes through 1 , 4 and 8 samples per pixel.
+ * Button Z : built with GLPBO_TRACE , writes the next trace_frames frames to trace.json.
 */
 void GLPbo::emulate ()
 {
+#if defined( GLPBO_TRACE )
+	Trace::next_frame ();
+#endif
+	GLPBO_TRACE_SCOPE ( "frame" );
 
 	// write window title with current fps ...
 	std::stringstream sstr;
 	sstr << std::fixed << std::setprecision ( 2 ) << GLHelper::title << ": "
 		<< " | fps : " << GLHelper::fps
-		<< " | vertices : " << vertices_
-		<< " | triangles : " << triangle_
-		<< " | culled : " << culled_ << " | ";
-	switch( mode )
-	{
-		case Mode::wireframe_black:
-			sstr << "Wireframe Black";
-			break;
-		case Mode::shadow_mapping:
-			sstr << "ShadowMap";
-			break;
-		case Mode::faceted:
-			sstr << "Faceted";
-			break;
-		case Mode::point_light:
-			sstr << "PointLight";
-			break;
-			case Mode::texture:
-			sstr << "Texture";
-			break;
-			case Mode::texture_faceted:
-			sstr << "TextureFaceted";
-			break;
-			case Mode::texture_point_light:
-			sstr << "TexturePointLight";
-			break;
-	}
+		<< " | vertices : " << frame_statistics.vertices
+		<< " | lod : " << lod_level
+		<< " | lights : " << point_lights.size ()
+		<< " | msaa : " << sample_counts[ sample_count_index ] << "x"
+		<< " | filter : " << ( texture.mip_filter == Texture::MipFilter::linear ? "trilinear" :
+			texture.mip_filter == Texture::MipFilter::nearest ? "bilinear nearest mip" : texture.filter == Texture::Filter::bilinear ? "bilinear" : "nearest" )
+		<< " | texture : " << ( texture.format == Texture::Format::bc1 ? "bc1 " : texture.format == Texture::Format::bc3 ? "bc3 " : "rgba8 " ) << texture.Bytes () / 1024 << " KB"
+		<< " | triangles : " << frame_statistics.primitives
+		<< " | clipped : " << frame_statistics.clipped
+		<< " | culled : " << frame_statistics.culled
+		<< " | fragments : " << frame_statistics.fragments
+		<< " | occluded : " << frame_statistics.depth_failed
+		<< " | threads : " << thread_pool.active () << " | " << mode_names[ static_cast< int >( mode ) ];
+#if defined( GLPBO_HEADLESS )
+	GLHelper::status = sstr.str ();
+#else
 	glfwSetWindowTitle ( GLHelper::ptr_window , sstr.str ().c_str () );
+#endif
 
 
-	triangle_ = 0;
-	culled_ = 0;
-	vertices_ = all_model_data[ current_model ].second.pm.size ();
-
-	clear_depth_buffer ();
+#if defined( GLPBO_HEADLESS )
+	double const seconds = GLHelper::time;
+#else
+	double const seconds = glfwGetTime ();
+#endif
+	double _cos = cos ( seconds ) < 0 ? -cos ( seconds ) : cos ( seconds );
 
-	double _cos = cos ( glfwGetTime () ) < 0 ? -cos ( glfwGetTime () ) : cos ( glfwGetTime () );
-
-	double _sin = sin ( glfwGetTime () ) < 0 ? -sin ( glfwGetTime () ) : sin ( glfwGetTime () );
+	double _sin = sin ( seconds ) < 0 ? -sin ( seconds ) : sin ( seconds );
 
 	set_clear_color ( static_cast< int >( _cos * 255.0 ) , static_cast< int >( _cos * 100.0 ) , static_cast< int >( _sin * 255.0 ) );
 
-	// binds the pbo buffer
-	glBindBuffer ( GL_PIXEL_UNPACK_BUFFER , pboid );
-
-	ptr_to_pbo = reinterpret_cast< Color* >( glMapNamedBuffer ( pboid , GL_WRITE_ONLY ) );
-
-	clear_color_buffer ();
-
-	std::default_random_engine dre;
-
-	dre.seed ( 15 );
-
-	std::uniform_real_distribution<float> urdf ( -1.0 , 1.0 );
+#if !defined( GLPBO_HEADLESS )
+	{
+		GLPBO_TRACE_SCOPE ( "map" );
+		// binds the pbo buffer
+		glBindBuffer ( GL_PIXEL_UNPACK_BUFFER , pboid );
 
-	GLPbo::viewport_transform ( all_model_data[ current_model ].second );
+		ptr_to_pbo = reinterpret_cast< Color* >( glMapNamedBuffer ( pboid , GL_WRITE_ONLY ) );
+	}
+#endif
 
 	if( GLHelper::keystateM && GLHelper::keystateM != key_m_last )
 	{
@@ -222,107 +705,168 @@ void GLPbo::emulate ()
 		rotate = !rotate;
 	}
 
+	// toggle between single-threaded and all hardware threads
+	if( GLHelper::keystateT && GLHelper::keystateT != key_t_last )
+	{
+		thread_pool.set_active ( thread_pool.active () > 1 ? 1 : thread_pool.size () );
+	}
+
 	key_m_last = GLHelper::keystateM;
 	key_r_last = GLHelper::keystateR;
 	key_w_last = GLHelper::keystateW;
+	// cycle the number of lights
+	if( GLHelper::keystateK && GLHelper::keystateK != key_k_last )
+	{
+		light_count_index = ( light_count_index + 1 ) % static_cast< int >( sizeof ( light_counts ) / sizeof ( light_counts[ 0 ] ) );
+		set_light_count ( light_counts[ light_count_index ] );
+	}
+
+	if( GLHelper::keystateV && GLHelper::keystateV != key_v_last )
+	{
+		// nearest , bilinear , bilinear from the nearest mip level , trilinear
+		if( texture.filter == Texture::Filter::nearest )
+		{
+			texture.filter = Texture::Filter::bilinear;
+		}
+		else if( texture.mip_filter == Texture::MipFilter::none )
+		{
+			texture.mip_filter = Texture::MipFilter::nearest;
+		}
+		else if( texture.mip_filter == Texture::MipFilter::nearest )
+		{
+			texture.mip_filter = Texture::MipFilter::linear;
+		}
+		else
+		{
+			texture.filter = Texture::Filter::nearest;
+			texture.mip_filter = Texture::MipFilter::none;
+		}
+	}
+
+	// reloads the texture to compress it afresh, compressing a decoded
+	// compressed texture would lose more
+	if( GLHelper::keystateC && GLHelper::keystateC != key_c_last )
+	{
+		Texture::Format format = texture.format == Texture::Format::rgba8 ? Texture::Format::bc1 :
+			texture.format == Texture::Format::bc1 ? Texture::Format::bc3 : Texture::Format::rgba8;
+		texture.ReadFile ( texture_file );
+		texture.Compress ( format );
+	}
+
+	key_t_last = GLHelper::keystateT;
+	key_k_last = GLHelper::keystateK;
+	key_v_last = GLHelper::keystateV;
+	key_c_last = GLHelper::keystateC;
+
+	if( GLHelper::keystateA && GLHelper::keystateA != key_a_last )
+	{
+		sample_count_index = ( sample_count_index + 1 ) % static_cast< int >( sizeof ( sample_counts ) / sizeof ( sample_counts[ 0 ] ) );
+	}
+	key_a_last = GLHelper::keystateA;
+
+#if defined( GLPBO_TRACE )
+	if( GLHelper::keystateZ && GLHelper::keystateZ != key_z_last )
+	{
+		Trace::start ( trace_default_file , trace_frames );
+	}
+	key_z_last = GLHelper::keystateZ;
+#endif
 
 	if( rotate )
 	{
 		rotation_angle += GLHelper::update_time () * 2.0;
 	}
 
-	point_light.transform_position = glm::inverse ( all_model_data[ current_model ].second.model_transform ) * point_light.position;
-
+	// after the keys and the rotation, so that the model drawn is the one
+	// transformed for this frame
+	Model& model = select_lod ( current_model );
+	viewport_transform ( model );
+	// lights are shaded in model space
+	glm::mat3 to_model = glm::inverse ( model.model_transform );
+	for( PointLight& point_light : point_lights )
+	{
+		point_light.transform_position = to_model * point_light.position;
+	}
 
-	for( size_t i = 0 ; i < all_model_data[ current_model ].second.tri.size (); i += 3 )
+	// front end : cull and sort the triangles into screen tiles, then let
+	// the workers rasterize whole tiles. Tiles never overlap, so no two threads
+	// touch the same pixel of the PBO or the framebuffer.
+	cull_triangles ( model );
+	if( mode == Mode::wireframe_black )
 	{
-		++triangle_ ;
-		GLubyte rand_r = static_cast< GLubyte >( urdf ( dre ) * 255 );
-		GLubyte rand_g = static_cast< GLubyte >( urdf ( dre ) * 255 );
-		GLubyte rand_b = static_cast< GLubyte >( urdf ( dre ) * 255 );
-		switch( mode )
-		{
-			case Mode::wireframe_black:
-				GLPbo::render_triangle_wireframe ( all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i ] ] ,
-												   all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-												   all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 2 ] ] ,
-												   { 0, 0, 0 ,255 } );
-				break;
-			case Mode::shadow_mapping:
-				GLPbo::render_shadow_map ( all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i ] ] ,
-										   all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-										   all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 2 ] ] );
-				break;
-			case Mode::point_light:
-				GLPbo::render_point_light ( all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i ] ] ,
-											all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-											all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 2 ] ] ,
-											all_model_data[ current_model ].second ,
-											all_model_data[ current_model ].second.tri[ i ] ,
-											all_model_data[ current_model ].second.tri[ i + 1 ] ,
-											all_model_data[ current_model ].second.tri[ i + 2 ] );
-				break;
-			case Mode::faceted:
-				GLPbo::render_faceted ( all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i ] ] ,
-										all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-										all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 2 ] ] ,
-										all_model_data[ current_model ].second ,
-										all_model_data[ current_model ].second.tri[ i ] ,
-										all_model_data[ current_model ].second.tri[ i + 1 ] ,
-										all_model_data[ current_model ].second.tri[ i + 2 ] );
-				break;
+		bin_edges ( model );
+	}
+	else
+	{
+		bin_triangles ( model );
+	}
+	assign_lights ();
 
-			case Mode::texture:
-				GLPbo::render_texture ( all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i ] ] ,
-										all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-										all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 2 ] ] ,
-										all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i ] ] ,
-										all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-										all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i + 2 ] ] );
-				break;
+	// lines and the visibility buffer are only ever single-sampled
+	int samples = mode == Mode::wireframe_black || mode == Mode::visibility_buffer ? 1 : sample_counts[ sample_count_index ];
+	if( framebuffer.samples != samples )
+	{
+		framebuffer.Resize ( tile_cols * tile_rows , samples );
+	}
+	framebuffer.Clear ();
 
+	{
+		GLPBO_TRACE_SCOPE ( "tiles" );
+		thread_pool.parallel_for ( static_cast< int >( tile_bins.size () ) , [ &model ] ( int tile , int )
+		{
+			render_tile ( tile , model );
+		} );
+	}
 
-			case Mode::texture_point_light:
-				GLPbo::render_texture_point_light ( all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i ] ] ,
-													all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-													all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 2 ] ] ,
-													all_model_data[ current_model ].second ,
-													all_model_data[ current_model ].second.tri[ i ] ,
-													all_model_data[ current_model ].second.tri[ i + 1 ] ,
-													all_model_data[ current_model ].second.tri[ i + 2 ] ,
-													all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i ] ] ,
-													all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-													all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i + 2 ] ] );
-				break;
-			case Mode::texture_faceted:
-				GLPbo::render_texture_faceted ( all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i ] ] ,
-													all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-													all_model_data[ current_model ].second.pd[ all_model_data[ current_model ].second.tri[ i + 2 ] ] ,
-													all_model_data[ current_model ].second ,
-													all_model_data[ current_model ].second.tri[ i ] ,
-													all_model_data[ current_model ].second.tri[ i + 1 ] ,
-													all_model_data[ current_model ].second.tri[ i + 2 ] ,
-													all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i ] ] ,
-													all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i + 1 ] ] ,
-													all_model_data[ current_model ].second.tex[ all_model_data[ current_model ].second.tri[ i + 2 ] ] );
-				break;
+	// the workers are done with the frame, their counters can be gathered
+	frame_statistics = {};
+	for( std::unique_ptr<ThreadCounters>& counters : thread_counters_list )
+	{
+		frame_statistics.Add ( counters->statistics );
+		counters->statistics = {};
+	}
+	// every triangle that passed culling goes into the histogram with the
+	// pixels all threads counted for it. The wireframe has no triangles
+	if( mode != Mode::wireframe_black )
+	{
+		for( GLuint i : visible_triangles )
+		{
+			unsigned int pixels = 0;
+			for( std::unique_ptr<ThreadCounters>& counters : thread_counters_list )
+			{
+				if( i / 3 < counters->triangle_pixels.size () )
+				{
+					pixels += counters->triangle_pixels[ i / 3 ];
+					counters->triangle_pixels[ i / 3 ] = 0;
+				}
+			}
+			++frame_statistics.pixels_per_triangle[ HistogramBucket ( pixels ) ];
 		}
 	}
 
-	glUnmapNamedBuffer ( pboid );
+#if !defined( GLPBO_HEADLESS )
+	{
+		GLPBO_TRACE_SCOPE ( "unmap" );
+		glUnmapNamedBuffer ( pboid );
+	}
 
 	// bind the texture
 	glBindTexture ( GL_TEXTURE_2D , texid );
 
-	glTextureSubImage2D ( texid , 0 , 0 , 0 , width , height , GL_RGBA , GL_UNSIGNED_BYTE , 0 );
+	{
+		GLPBO_TRACE_SCOPE ( "upload" );
+		glTextureSubImage2D ( texid , 0 , 0 , 0 , width , height , GL_RGBA , GL_UNSIGNED_BYTE , 0 );
+	}
 
 	// unbind buffer
 	glBindBuffer ( GL_PIXEL_UNPACK_BUFFER , 0 );
 
 	// unbind texture
 	glBindTexture ( GL_TEXTURE_2D , 0 );
+#endif
 }
 
+#if !defined( GLPBO_HEADLESS )
 /**
  * @brief
  * set opengl rectangle quad
@@ -345,6 +889,7 @@ void GLPbo::draw_fullwindow_quad ()
 	// draw
 	glDrawElements ( GL_TRIANGLE_STRIP , elem_cnt , GL_UNSIGNED_SHORT , nullptr );
 }
+#endif
 
 /**
  * @brief
@@ -372,6 +917,12 @@ void GLPbo::init ( GLsizei w , GLsizei h )
 	// set the color in data member GLPbo::clear_clr() through GLPbo::set_clear_color ().
 	GLPbo::set_clear_color ( 255 , 0 , 255 , 255 );
 
+#if defined( GLPBO_HEADLESS )
+	// no PBO without a context , the frames stay in memory for the caller
+	GLPbo::ptr_to_pbo = static_cast< GLPbo::Color* >( ::operator new ( byte_cnt , frame_alignment ) );
+
+	GLPbo::clear_color_buffer ();
+#else
 	// initialize GLPbo::pboid by creating a PBO with an image store of GLPbo::byte_cnt bytes ( recall the PBO has dimensions GLPbo::width GLPbo::height with each pixel - I use the term pixel rather than texel to conform to the GL spec - having a 32 - bit RGBA value ).
 	glCreateBuffers ( 1 , &pboid );
 
@@ -407,16 +958,9 @@ void GLPbo::init ( GLsizei w , GLsizei h )
 	GLPbo::setup_quad_vao ();
 
 	GLPbo::setup_shdrpgm ();
+#endif
 
-	GLPbo::model_data.pm.clear ();
-	GLPbo::model_data.nml.clear ();
-	GLPbo::model_data.tex.clear ();
-	GLPbo::model_data.tri.clear ();
-
-	if( DPML::parse_obj_mesh ( "../meshes/ogre.obj" , GLPbo::model_data.pm , GLPbo::model_data.nml , GLPbo::model_data.tex , GLPbo::model_data.tri , true , true , true ) )
-	{
-		GLPbo::all_model_data.push_back ( std::make_pair ( "../meshes/orge.obj" , GLPbo::model_data ) );
-	}
+	load_model ( "../meshes/ogre.obj" );
 
 	viewport_transform ( all_model_data.back ().second );
 
@@ -424,14 +968,19 @@ void GLPbo::init ( GLsizei w , GLsizei h )
 	//file.close ();
 
 
-	depth_buffer.resize ( width * height );
+	setup_tiles ();
+
+	thread_pool.start ( std::max ( 1u , std::thread::hardware_concurrency () ) );
+
+	select_kernels ();
 
-	texture.ReadFile ( "../images/ogre.tex" );
+	texture.ReadFile ( texture_file );
 
 
 
 }
 
+#if !defined( GLPBO_HEADLESS )
 /**
  * @brief
  * setup quad vao using opengl ,
@@ -546,6 +1095,7 @@ void GLPbo::setup_shdrpgm ()
 	shdr_pgm.PrintActiveAttribs ();
 	shdr_pgm.PrintActiveUniforms ();
 }
+#endif
 
 /**
  * @brief
@@ -553,17 +1103,164 @@ void GLPbo::setup_shdrpgm ()
 */
 void GLPbo::cleanup ()
 {
+#if defined( GLPBO_TRACE )
+	Trace::finish ();
+#endif
+	thread_pool.stop ();
+#if defined( GLPBO_HEADLESS )
+	::operator delete ( ptr_to_pbo , frame_alignment );
+	ptr_to_pbo = nullptr;
+#else
 	glDeleteVertexArrays ( 1 , &vaoid );
 	glDeleteBuffers ( 1 , &pboid );
 	glDeleteTextures ( 1 , &texid );
+#endif
 }
 
 /**
  * @brief
- * specify clear values for the color buffers
- * @param glpbo_color
- * specify color to be set
-*/
+ * loads an OBJ mesh , reorders it for the vertex cache , cuts it into
+ * meshlets and adds it to all_model_data along with its levels of detail
+ * @param file
+ * path of the mesh , also the name it is kept under
+ * @return
+ * false if DPML could not parse the file
+*/
+bool GLPbo::load_model ( std::string const& file )
+{
+	GLPbo::model_data.pm.clear ();
+	GLPbo::model_data.nml.clear ();
+	GLPbo::model_data.tex.clear ();
+	GLPbo::model_data.tri.clear ();
+
+	if( !DPML::parse_obj_mesh ( file , GLPbo::model_data.pm , GLPbo::model_data.nml , GLPbo::model_data.tex , GLPbo::model_data.tri , true , true , true ) )
+	{
+		return false;
+	}
+	optimize_mesh ( GLPbo::model_data , file );
+	build_meshlets ( GLPbo::model_data , file );
+	build_edges ( GLPbo::model_data , file );
+	GLPbo::all_model_data.push_back ( std::make_pair ( file , GLPbo::model_data ) );
+	GLPbo::all_model_lods.emplace_back ();
+	build_lods ( GLPbo::model_data , file , GLPbo::all_model_lods.back () );
+	return true;
+}
+
+/**
+ * @brief
+ * sizes the visibility buffer , the framebuffer and the tile lists for
+ * width x height
+*/
+void GLPbo::setup_tiles ()
+{
+	visibility_buffer.resize ( width * height );
+
+	tile_cols = ( width + tile_size - 1 ) / tile_size;
+	tile_rows = ( height + tile_size - 1 ) / tile_size;
+	framebuffer.Resize ( tile_cols * tile_rows , framebuffer.samples );
+	tile_bins.resize ( tile_cols * tile_rows );
+	tile_lights.resize ( tile_cols * tile_rows );
+
+	// the main thread writes straight to the whole framebuffer until it
+	// takes part in rendering tiles
+	scissor = { 0 , 0 , width , height };
+}
+
+#if defined( GLPBO_HEADLESS )
+/**
+ * @brief
+ * changes the size of the frames emulate () renders
+ * @param w , h
+ * new width and height
+*/
+void GLPbo::resize ( GLsizei w , GLsizei h )
+{
+	GLPbo::width = w;
+	GLPbo::height = h;
+	GLPbo::pixel_cnt = width * height;
+	GLPbo::byte_cnt = pixel_cnt * sizeof ( Color );
+
+	::operator delete ( ptr_to_pbo , frame_alignment );
+	GLPbo::ptr_to_pbo = static_cast< GLPbo::Color* >( ::operator new ( byte_cnt , frame_alignment ) );
+	GLPbo::clear_color_buffer ();
+
+	setup_tiles ();
+}
+#endif
+
+/**
+ * @brief
+ * number of render modes , which the W key cycles through
+*/
+int GLPbo::mode_count ()
+{
+	return static_cast< int >( Mode::Count );
+}
+
+/**
+ * @brief
+ * name of a render mode as the window title shows it
+ * @param index
+ * mode in [0, mode_count ())
+*/
+char const* GLPbo::mode_name ( int index )
+{
+	return mode_names[ index ];
+}
+
+/**
+ * @brief
+ * sets what the following frames render , as the W and M keys would
+ * @param index
+ * mode in [0, mode_count ())
+ * @param model
+ * index into all_model_data
+*/
+void GLPbo::select ( int index , int model )
+{
+	mode = static_cast< Mode >( index );
+	current_model = model;
+}
+
+/**
+ * @brief
+ * counters of the last frame emulate () rendered , as shown in the window
+ * title
+*/
+GLPbo::PipelineStatistics const& GLPbo::statistics ()
+{
+	return frame_statistics;
+}
+
+/**
+ * @brief
+ * adds the counters of another thread or frame to these
+ * @param other
+ * counters to add
+*/
+void GLPbo::PipelineStatistics::Add ( PipelineStatistics const& other )
+{
+	vertices += other.vertices;
+	primitives += other.primitives;
+	clipped += other.clipped;
+	culled += other.culled;
+	pixels += other.pixels;
+	depth_passed += other.depth_passed;
+	depth_failed += other.depth_failed;
+	fragments += other.fragments;
+	texture_samples += other.texture_samples;
+	for( int b = 0 ; b < histogram_buckets ; ++b )
+	{
+		pixels_per_triangle[ b ] += other.pixels_per_triangle[ b ];
+	}
+}
+
+/**
+ * @brief
+ * specify clear values for the color buffers
+ * @param glpbo_color
+ * specify color to be set
+*/
 void GLPbo::set_clear_color ( GLPbo::Color glpbo_color )
 {
 	clear_clr = glpbo_color;
@@ -587,19 +1284,20 @@ set_pixel to write to specific locations in the chunk of memory.
 */
 void GLPbo::clear_color_buffer ()
 {
-	std::fill ( GLPbo::ptr_to_pbo , GLPbo::ptr_to_pbo + pixel_cnt , clear_clr );
+	fill_colors ( GLPbo::ptr_to_pbo , pixel_cnt , clear_clr );
 }
 
 /**
  * @brief
  * position coordinates must be transformed by viewport transformation matrix to window viewport coordinates pd.
+ * The vertices are transformed in batches of vertex_batch spread over the thread
+ * pool, and not at all while neither the rotation nor the viewport changes.
  * @param model_transfrom
  * model data to be transformed
 */
 void GLPbo::viewport_transform ( Model& model_transfrom )
 {
-	// clear model transform container before push back
-	model_transfrom.pd.clear ();
+	GLPBO_TRACE_SCOPE ( "transform" );
 	// rotation matrix
 	double angle = rotation_angle;
 	glm::mat3 m_rotation_x{ 1,				0,				0 ,
@@ -620,989 +1318,4009 @@ void GLPbo::viewport_transform ( Model& model_transfrom )
 									 0 , 			 0 , 1.0f / 2.0f , 0 ,
 						  width / 2.0f , height / 2.0f , 1.0f / 2.0f , 1 };
 
-	for( size_t i = 0 ; i < model_transfrom.pm.size () ; i++ )
+	if( model_transfrom.pm_x.size () != model_transfrom.pm.size () )
+	{
+		prepare_vertices ( model_transfrom );
+	}
+
+	glm::mat4 matrix = m_viewport * glm::mat4 ( model_transfrom.model_transform );
+	if( matrix == model_transfrom.pd_matrix )
+	{
+		return;
+	}
+	model_transfrom.pd_matrix = matrix;
+
+	// the viewport matrix only scales and translates
+	glm::vec3 scale{ m_viewport[ 0 ][ 0 ] , m_viewport[ 1 ][ 1 ] , m_viewport[ 2 ][ 2 ] };
+	glm::vec3 offset{ m_viewport[ 3 ] };
+
+	Model& model = model_transfrom;
+	glm::mat3 const& rotation = model.model_transform;
+	cull_meshlets ( model , rotation , scale , offset );
+
+	// a visible meshlet needs its own vertices and those of its sources
+	meshlet_needed.assign ( model.meshlets.size () , 0 );
+	for( GLuint m : model.visible_meshlets )
+	{
+		Meshlet const& meshlet = model.meshlets[ m ];
+		meshlet_needed[ m ] = 1;
+		for( GLuint s = 0 ; s < meshlet.source_cnt ; ++s )
+		{
+			meshlet_needed[ model.meshlet_sources[ meshlet.source_offset + s ] ] = 1;
+		}
+	}
+
+	// owned vertex ranges are consecutive, join them and cut the result into
+	// jobs of at most vertex_batch vertices
+	vertex_ranges.clear ();
+	for( size_t m = 0 ; m < model.meshlets.size () ; ++m )
+	{
+		if( !meshlet_needed[ m ] || model.meshlets[ m ].vertex_begin == model.meshlets[ m ].vertex_end )
+		{
+			continue;
+		}
+		size_t begin = model.meshlets[ m ].vertex_begin , end = model.meshlets[ m ].vertex_end;
+		if( !vertex_ranges.empty () && vertex_ranges.back ().second == begin && vertex_ranges.back ().second - vertex_ranges.back ().first < static_cast< size_t >( vertex_batch ) )
+		{
+			begin = vertex_ranges.back ().first;
+			vertex_ranges.pop_back ();
+		}
+		for( ; end - begin > static_cast< size_t >( vertex_batch ) ; begin += vertex_batch )
+		{
+			vertex_ranges.emplace_back ( begin , begin + vertex_batch );
+		}
+		vertex_ranges.emplace_back ( begin , end );
+	}
+	model.visible_vertices = 0;
+	for( std::pair<size_t , size_t> const& range : vertex_ranges )
 	{
-		glm::vec3 temp = model_transfrom.model_transform * model_transfrom.pm[ i ];
-		glm::vec4 temp_vec4 = m_viewport * glm::vec4{ temp , 1 };
-		model_transfrom.pd.push_back ( temp_vec4 );
+		model.visible_vertices += range.second - range.first;
 	}
+
+	thread_pool.parallel_for ( static_cast< int >( vertex_ranges.size () ) , [ & ] ( int job , int )
+	{
+		GLPBO_TRACE_SCOPE ( "transform batch" );
+		transform_vertices ( model , vertex_ranges[ job ].first , vertex_ranges[ job ].second , rotation , scale , offset );
+	} );
 }
 
 /**
  * @brief
- * rasterize the triangle primitives to generate wireframe images
- * @param p0
- * 1st vertices of the triangle
- * @param p1
- * 2nd vertices of the triangle
- * @param p2
- * 3rd vertices of the triangle
- * @param clr
- * color to render the triangle edges
- * @return
- * if triangle was successfully rendered which is not backface-culled.
+ * sets up the buffers of the vertex stage once for a model: the
+ * structure-of-arrays copy of pm and pd at its final size
+ * @param model
+ * model to prepare
 */
-bool GLPbo::render_triangle_wireframe ( glm::vec3 p0 , glm::vec3 p1 , glm::vec3 p2 , GLPbo::Color clr )
+void GLPbo::prepare_vertices ( Model& model )
 {
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
-	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
-	};
-	if( normal.z > 0 )
-	{
-		render_linebresenham ( ( GLint ) p0.x , ( GLint ) p0.y , ( GLint ) p1.x , ( GLint ) p1.y , clr );
-		render_linebresenham ( ( GLint ) p1.x , ( GLint ) p1.y , ( GLint ) p2.x , ( GLint ) p2.y , clr );
-		render_linebresenham ( ( GLint ) p2.x , ( GLint ) p2.y , ( GLint ) p0.x , ( GLint ) p0.y , clr );
-	}
-	else
+	size_t count = model.pm.size ();
+	model.pm_x.resize ( count );
+	model.pm_y.resize ( count );
+	model.pm_z.resize ( count );
+	for( size_t i = 0 ; i < count ; ++i )
 	{
-		return false;
+		model.pm_x[ i ] = model.pm[ i ].x;
+		model.pm_y[ i ] = model.pm[ i ].y;
+		model.pm_z[ i ] = model.pm[ i ].z;
 	}
-	return true ;
+	model.pd.resize ( count );
+	model.pd_matrix = glm::mat4 ( 0.0f );
 }
 
 /**
  * @brief
- * renders a flat shaded triangle
- * @param p0
- * 1st vertices of the triangle
- * @param p1
- * 2nd vertices of the triangle
- * @param p2
- * 3rd vertices of the triangle
- * @param clr
- * color to shade the triangle
+ * simulates a FIFO post-transform vertex cache over an index buffer
+ * @param tri
+ * triangle indices
+ * @param vertex_cnt
+ * number of vertices the indices refer to
  * @return
- * if triangle was successfully rendered which is not backface-culled.
+ * cache misses per triangle, between 0.5 for an ideal grid and 3
 */
-bool GLPbo::render_triangle ( glm::vec3 p0 , glm::vec3 p1 , glm::vec3 p2 , GLPbo::Color clr )
+float GLPbo::acmr ( std::vector<unsigned short> const& tri , size_t vertex_cnt )
 {
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
-	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
-	};
-	if( normal.z <= 0 )
+	if( tri.empty () )
 	{
-		return false;
+		return 0.0f;
 	}
 
-	glm::vec3 line0 = EdgeEqnTopLeft ( p1 , p2 );
-	glm::vec3 line1 = EdgeEqnTopLeft ( p2 , p0 );
-	glm::vec3 line2 = EdgeEqnTopLeft ( p0 , p1 );
-
-	float min_x = floor ( std::min ( { p0.x, p1.x ,p2.x } ) );
-	float max_x = ceil ( std::max ( { p0.x, p1.x ,p2.x } ) );
-	float min_y = floor ( std::min ( { p0.y, p1.y ,p2.y } ) );
-	float max_y = ceil ( std::max ( { p0.y, p1.y ,p2.y } ) );
-
-	bool top_left_e0 , top_left_e1 , top_left_e2 ;
-	float evaluation0 = EvaluateFragment ( line0 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e0 );
-	float evaluation1 = EvaluateFragment ( line1 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e1 );
-	float evaluation2 = EvaluateFragment ( line2 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e2 );
-
-	for( int y = ( int ) min_y ; y < ( int ) max_y ; ++y )
+	// time stamp of each vertex entering the cache, a vertex is cached while
+	// fewer than acmr_cache_size misses happened since
+	std::vector<size_t> entered ( vertex_cnt , 0 );
+	size_t misses = 0;
+	for( unsigned short index : tri )
 	{
-		float Hevaluation0 = evaluation0;
-		float Hevaluation1 = evaluation1;
-		float Hevaluation2 = evaluation2;
-
-		for( int x = ( int ) min_x ; x < ( int ) max_x ; ++x )
+		if( entered[ index ] == 0 || misses - entered[ index ] + 1 > static_cast< size_t >( acmr_cache_size ) )
 		{
-			if( PointInTriangleOptimized ( Hevaluation0 , Hevaluation1 , Hevaluation2 , { x + 0.5f , y + 0.5f, 0 } , { 0,0 } , top_left_e0 , top_left_e1 , top_left_e2 ) )
-			{
-				set_pixel ( x , y , clr );
-			}
-			Hevaluation0 += line0.x;
-			Hevaluation1 += line1.x;
-			Hevaluation2 += line2.x;
+			++misses;
+			entered[ index ] = misses;
 		}
-		evaluation0 += line0.y;
-		evaluation1 += line1.y;
-		evaluation2 += line2.y;
 	}
-	return false;
+	return static_cast< float >( misses ) / static_cast< float >( tri.size () / 3 );
 }
 
 /**
  * @brief
- * renders the triangle with smooth shading. I.e. same as flat shading just with barycentric interpolated colors.
- * @param p0
- * 1st vertices of the triangle
- * @param p1
- * 2nd vertices of the triangle
- * @param p2
- * 3rd vertices of the triangle
- * @param c0
- * color at 1st vertex.
- * @param c1
- * color at 2nd vertex.
- * @param c2
- * color at 3rd vertex.
- * @return bool
- * if triangle was successfully rendered which is not backface-culled
-*/
-bool GLPbo::render_triangle ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , glm::vec3 const& c0 , glm::vec3 const& c1 , glm::vec3 const& c2 )
-{
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
-	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
-	};
-	if( normal.z <= 0 )
+ * Tom Forsyth's linear-speed vertex cache optimization followed by a
+ * reordering of the vertices in order of first use. Scores every vertex by
+ * its position in a simulated LRU cache and by how many triangles still use
+ * it, and greedily emits the best triangle touching the cache.
+ * @param model
+ * model whose tri , pm , nml and tex are reordered in place
+ * @param name
+ * mesh name for the ACMR report
+*/
+void GLPbo::optimize_mesh ( Model& model , std::string const& name )
+{
+	size_t const vertex_cnt = model.pm.size ();
+	size_t const triangle_cnt = model.tri.size () / 3;
+	if( triangle_cnt == 0 )
 	{
-		return false;
+		return;
 	}
+	float const acmr_before = acmr ( model.tri , vertex_cnt );
 
-	glm::vec3 line0 = EdgeEqnTopLeft ( p1 , p2 );
-	glm::vec3 line1 = EdgeEqnTopLeft ( p2 , p0 );
-	glm::vec3 line2 = EdgeEqnTopLeft ( p0 , p1 );
-
-	float min_x = floor ( std::min ( { p0.x, p1.x ,p2.x } ) );
-	float max_x = ceil ( std::max ( { p0.x, p1.x ,p2.x } ) );
-	float min_y = floor ( std::min ( { p0.y, p1.y ,p2.y } ) );
-	float max_y = ceil ( std::max ( { p0.y, p1.y ,p2.y } ) );
-
-	bool top_left_e0 , top_left_e1 , top_left_e2 ;
-	float evaluation0 = EvaluateFragment ( line0 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e0 );
-	float evaluation1 = EvaluateFragment ( line1 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e1 );
-	float evaluation2 = EvaluateFragment ( line2 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e2 );
-
-	float double_area_triangle = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p2.x - p0.x ) * ( p1.y - p0.y );
+	constexpr int cache_size = 32;
+	auto vertex_score = [] ( int cache_position , int remaining ) -> float
+	{
+		if( remaining == 0 )
+		{
+			return -1.0f;
+		}
+		float score = 0.0f;
+		if( cache_position >= 0 )
+		{
+			// the three vertices of the last triangle get a fixed score so that
+			// the next triangle does not just pick whichever came first
+			score = cache_position < 3 ? 0.75f : std::pow ( 1.0f - ( cache_position - 3 ) / float ( cache_size - 3 ) , 1.5f );
+		}
+		// favour vertices with few triangles left, finishing them frees the cache
+		return score + 2.0f / std::sqrt ( static_cast< float >( remaining ) );
+	};
 
-	float sub_tri_e0 = evaluation0 / double_area_triangle;
-	float sub_tri_e1 = evaluation1 / double_area_triangle;
-	float sub_tri_e2 = evaluation2 / double_area_triangle;
+	// triangles using each vertex, as offsets into one adjacency array
+	std::vector<int> remaining ( vertex_cnt , 0 );
+	for( unsigned short index : model.tri )
+	{
+		++remaining[ index ];
+	}
+	std::vector<int> first ( vertex_cnt + 1 , 0 );
+	for( size_t v = 0 ; v < vertex_cnt ; ++v )
+	{
+		first[ v + 1 ] = first[ v ] + remaining[ v ];
+	}
+	std::vector<int> adjacency ( model.tri.size () );
+	std::vector<int> filled ( first.begin () , first.end () - 1 );
+	for( size_t t = 0 ; t < triangle_cnt ; ++t )
+	{
+		for( int k = 0 ; k < 3 ; ++k )
+		{
+			adjacency[ filled[ model.tri[ t * 3 + k ] ]++ ] = static_cast< int >( t );
+		}
+	}
 
-	float sub_tri_e0_inc_x = line0.x / double_area_triangle;
-	float sub_tri_e1_inc_x = line1.x / double_area_triangle;
-	float sub_tri_e2_inc_x = line2.x / double_area_triangle;
+	std::vector<int> cache_position ( vertex_cnt , -1 );
+	std::vector<float> score ( vertex_cnt );
+	for( size_t v = 0 ; v < vertex_cnt ; ++v )
+	{
+		score[ v ] = vertex_score ( -1 , remaining[ v ] );
+	}
+	std::vector<float> triangle_score ( triangle_cnt );
+	for( size_t t = 0 ; t < triangle_cnt ; ++t )
+	{
+		triangle_score[ t ] = score[ model.tri[ t * 3 ] ] + score[ model.tri[ t * 3 + 1 ] ] + score[ model.tri[ t * 3 + 2 ] ];
+	}
 
-	float sub_tri_e0_inc_y = line0.y / double_area_triangle;
-	float sub_tri_e1_inc_y = line1.y / double_area_triangle;
-	float sub_tri_e2_inc_y = line2.y / double_area_triangle;
+	std::vector<bool> emitted ( triangle_cnt , false );
+	std::vector<unsigned short> tri;
+	tri.reserve ( model.tri.size () );
+	std::vector<int> cache;
+	cache.reserve ( cache_size + 3 );
+	size_t scan = 0;
+	int best = -1;
 
-	for( int y = ( int ) min_y ; y < ( int ) max_y ; ++y )
+	for( size_t n = 0 ; n < triangle_cnt ; ++n )
 	{
-		float Hevaluation0 = evaluation0;
-		float Hevaluation1 = evaluation1;
-		float Hevaluation2 = evaluation2;
+		if( best < 0 )
+		{
+			// nothing in the cache has triangles left, take the best of the rest
+			float best_score = -1.0f;
+			for( size_t t = scan ; t < triangle_cnt ; ++t )
+			{
+				if( !emitted[ t ] && triangle_score[ t ] > best_score )
+				{
+					best_score = triangle_score[ t ];
+					best = static_cast< int >( t );
+				}
+			}
+			while( scan < triangle_cnt && emitted[ scan ] )
+			{
+				++scan;
+			}
+		}
 
-		float Hsub_tri_e0 = sub_tri_e0;
-		float Hsub_tri_e1 = sub_tri_e1;
-		float Hsub_tri_e2 = sub_tri_e2;
+		emitted[ best ] = true;
+		unsigned short const* corner = &model.tri[ best * 3 ];
+		tri.insert ( tri.end () , corner , corner + 3 );
 
-		for( int x = ( int ) min_x ; x < ( int ) max_x ; ++x )
+		// move the triangle's vertices to the front of the LRU cache
+		std::vector<int> next ( corner , corner + 3 );
+		for( int v : cache )
+		{
+			if( v != corner[ 0 ] && v != corner[ 1 ] && v != corner[ 2 ] )
+			{
+				next.push_back ( v );
+			}
+		}
+		for( int k = 0 ; k < 3 ; ++k )
 		{
-			if( PointInTriangleOptimized ( Hevaluation0 , Hevaluation1 , Hevaluation2 , { x + 0.5f , y + 0.5f, 0 } , { 0,0 } , top_left_e0 , top_left_e1 , top_left_e2 ) )
+			int v = corner[ k ];
+			--remaining[ v ];
+			for( int* a = &adjacency[ first[ v ] ] , *last = &adjacency[ first[ v ] ] + remaining[ v ] ; a <= last ; ++a )
 			{
-				glm::vec3 color = Hsub_tri_e0 * c0 + Hsub_tri_e1 * c1 + Hsub_tri_e2 * c2;
-				set_pixel ( x , y , { ( GLubyte ) color.x , ( GLubyte ) color.y , ( GLubyte ) color.z , 255 } );
+				if( *a == best )
+				{
+					std::swap ( *a , *last );
+					break;
+				}
 			}
-			Hevaluation0 += line0.x;
-			Hevaluation1 += line1.x;
-			Hevaluation2 += line2.x;
+		}
 
-			Hsub_tri_e0 += sub_tri_e0_inc_x;
-			Hsub_tri_e1 += sub_tri_e1_inc_x;
-			Hsub_tri_e2 += sub_tri_e2_inc_x;
+		// rescore the cache and the triangles touching it, vertices falling out
+		// of the cache are rescored too
+		for( size_t c = 0 ; c < next.size () ; ++c )
+		{
+			int v = next[ c ];
+			cache_position[ v ] = c < static_cast< size_t >( cache_size ) ? static_cast< int >( c ) : -1;
+			score[ v ] = vertex_score ( cache_position[ v ] , remaining[ v ] );
+		}
+		best = -1;
+		float best_score = -1.0f;
+		for( int v : next )
+		{
+			for( int a = first[ v ] ; a < first[ v ] + remaining[ v ] ; ++a )
+			{
+				int t = adjacency[ a ];
+				triangle_score[ t ] = score[ model.tri[ t * 3 ] ] + score[ model.tri[ t * 3 + 1 ] ] + score[ model.tri[ t * 3 + 2 ] ];
+				if( triangle_score[ t ] > best_score )
+				{
+					best_score = triangle_score[ t ];
+					best = t;
+				}
+			}
+		}
+		if( next.size () > static_cast< size_t >( cache_size ) )
+		{
+			next.resize ( cache_size );
+		}
+		cache.swap ( next );
+	}
 
+	// vertices in order of first use, so that consecutive triangles fetch
+	// neighbouring vertices
+	std::vector<int> remap ( vertex_cnt , -1 );
+	std::vector<glm::vec3> pm , nml;
+	std::vector<glm::vec2> tex;
+	pm.reserve ( vertex_cnt );
+	for( unsigned short& index : tri )
+	{
+		if( remap[ index ] < 0 )
+		{
+			remap[ index ] = static_cast< int >( pm.size () );
+			pm.push_back ( model.pm[ index ] );
+			if( model.nml.size () == vertex_cnt )
+			{
+				nml.push_back ( model.nml[ index ] );
+			}
+			if( model.tex.size () == vertex_cnt )
+			{
+				tex.push_back ( model.tex[ index ] );
+			}
 		}
-		evaluation0 += line0.y;
-		evaluation1 += line1.y;
-		evaluation2 += line2.y;
+		index = static_cast< unsigned short >( remap[ index ] );
+	}
 
-		sub_tri_e0 += sub_tri_e0_inc_y;
-		sub_tri_e1 += sub_tri_e1_inc_y;
-		sub_tri_e2 += sub_tri_e2_inc_y;
+	model.tri.swap ( tri );
+	model.pm.swap ( pm );
+	if( model.nml.size () == vertex_cnt )
+	{
+		model.nml.swap ( nml );
+	}
+	if( model.tex.size () == vertex_cnt )
+	{
+		model.tex.swap ( tex );
 	}
 
-	return false;
+	std::cout << name << " : ACMR " << std::fixed << std::setprecision ( 3 ) << acmr_before << " -> " << acmr ( model.tri , model.pm.size () ) << std::endl;
 }
 
-bool GLPbo::render_texture ( glm::vec3 p0 , glm::vec3 p1 , glm::vec3 p2 , glm::vec2 texture0 , glm::vec2 texture1 , glm::vec2 texture2 )
+/**
+ * @brief
+ * cuts Model::tri, in the vertex cache order left by optimize_mesh, into
+ * meshlets of at most meshlet_vertices vertices and meshlet_triangles
+ * triangles, and computes the bounding sphere and normal cone of each.
+ * Every meshlet owns the vertices from the end of the previous one up to
+ * the highest it uses, with vertices in order of first use that is exactly
+ * the vertices it uses first.
+ * @param model
+ * model whose meshlets and meshlet_sources are rebuilt
+ * @param name
+ * mesh name for the report
+*/
+void GLPbo::build_meshlets ( Model& model , std::string const& name )
 {
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
+	model.meshlets.clear ();
+	model.meshlet_sources.clear ();
+	model.visible_meshlets.clear ();
+	model.visible_vertices = 0;
+	size_t const vertex_cnt = model.pm.size ();
+	size_t const triangle_cnt = model.tri.size () / 3;
+
+	// greedy scan, a meshlet ends where the next triangle no longer fits
+	std::vector<GLuint> stamp ( vertex_cnt , 0 );
+	GLuint meshlet_vertex_cnt = 0;
+	Meshlet meshlet{};
+	for( size_t t = 0 ; t < triangle_cnt ; ++t )
 	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
-	};
-	if( normal.z <= 0 )
+		unsigned short const* corner = &model.tri[ t * 3 ];
+		auto new_vertices = [ & ] ( GLuint id )
+		{
+			return ( stamp[ corner[ 0 ] ] != id ) + ( stamp[ corner[ 1 ] ] != id && corner[ 1 ] != corner[ 0 ] ) +
+				( stamp[ corner[ 2 ] ] != id && corner[ 2 ] != corner[ 0 ] && corner[ 2 ] != corner[ 1 ] );
+		};
+		GLuint id = static_cast< GLuint >( model.meshlets.size () ) + 1;
+		if( meshlet.triangle_cnt == meshlet_triangles || meshlet_vertex_cnt + new_vertices ( id ) > meshlet_vertices )
+		{
+			model.meshlets.push_back ( meshlet );
+			meshlet = Meshlet{};
+			meshlet.triangle_offset = static_cast< GLuint >( t );
+			meshlet.vertex_begin = meshlet.vertex_end = model.meshlets.back ().vertex_end;
+			meshlet_vertex_cnt = 0;
+			++id;
+		}
+		for( int k = 0 ; k < 3 ; ++k )
+		{
+			if( stamp[ corner[ k ] ] != id )
+			{
+				stamp[ corner[ k ] ] = id;
+				++meshlet_vertex_cnt;
+			}
+			meshlet.vertex_end = std::max ( meshlet.vertex_end , static_cast< GLuint >( corner[ k ] ) + 1u );
+		}
+		++meshlet.triangle_cnt;
+	}
+	if( meshlet.triangle_cnt )
 	{
-		++culled_;
-		return false;
+		model.meshlets.push_back ( meshlet );
 	}
 
-	glm::vec3 line0 = EdgeEqnTopLeft ( p1 , p2 );
-	glm::vec3 line1 = EdgeEqnTopLeft ( p2 , p0 );
-	glm::vec3 line2 = EdgeEqnTopLeft ( p0 , p1 );
-
-	float min_x = floor ( std::min ( { p0.x, p1.x ,p2.x } ) );
-	float max_x = ceil ( std::max ( { p0.x, p1.x ,p2.x } ) );
-	float min_y = floor ( std::min ( { p0.y, p1.y ,p2.y } ) );
-	float max_y = ceil ( std::max ( { p0.y, p1.y ,p2.y } ) );
-
-	bool top_left_e0 , top_left_e1 , top_left_e2 ;
-	float evaluation0 = EvaluateFragment ( line0 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e0 );
-	float evaluation1 = EvaluateFragment ( line1 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e1 );
-	float evaluation2 = EvaluateFragment ( line2 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e2 );
-
-	float double_area_triangle = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p2.x - p0.x ) * ( p1.y - p0.y );
-
-	float sub_tri_e0 = evaluation0 / double_area_triangle;
-	float sub_tri_e1 = evaluation1 / double_area_triangle;
-	float sub_tri_e2 = evaluation2 / double_area_triangle;
-
-	float sub_tri_e0_inc_x = line0.x / double_area_triangle;
-	float sub_tri_e1_inc_x = line1.x / double_area_triangle;
-	float sub_tri_e2_inc_x = line2.x / double_area_triangle;
-
-	float sub_tri_e0_inc_y = line0.y / double_area_triangle;
-	float sub_tri_e1_inc_y = line1.y / double_area_triangle;
-	float sub_tri_e2_inc_y = line2.y / double_area_triangle;
-
-	for( int y = ( int ) min_y ; y < ( int ) max_y ; ++y )
+	std::vector<GLuint> owner ( vertex_cnt , 0 );
+	for( GLuint m = 0 ; m < model.meshlets.size () ; ++m )
 	{
-		float Hevaluation0 = evaluation0;
-		float Hevaluation1 = evaluation1;
-		float Hevaluation2 = evaluation2;
+		std::fill ( owner.begin () + model.meshlets[ m ].vertex_begin , owner.begin () + model.meshlets[ m ].vertex_end , m );
+	}
 
-		float Hsub_tri_e0 = sub_tri_e0;
-		float Hsub_tri_e1 = sub_tri_e1;
-		float Hsub_tri_e2 = sub_tri_e2;
+	for( GLuint m = 0 ; m < model.meshlets.size () ; ++m )
+	{
+		Meshlet& current = model.meshlets[ m ];
+		unsigned short const* first = &model.tri[ current.triangle_offset * 3 ];
+		unsigned short const* last = first + current.triangle_cnt * 3;
 
-		for( int x = ( int ) min_x ; x < ( int ) max_x ; ++x )
+		// the meshlets owning vertices below vertex_begin
+		current.source_offset = static_cast< GLuint >( model.meshlet_sources.size () );
+		for( unsigned short const* index = first ; index != last ; ++index )
 		{
-			if( PointInTriangleOptimized ( Hevaluation0 , Hevaluation1 , Hevaluation2 , { x + 0.5f , y + 0.5f, 0 } , { 0,0 } , top_left_e0 , top_left_e1 , top_left_e2 ) )
+			if( *index < current.vertex_begin )
 			{
-				glm::vec2 color = Hsub_tri_e0 * texture0 + Hsub_tri_e1 * texture1 + Hsub_tri_e2 * texture2;
-				glm::vec3 tex_color = texture.GetColor ( color );
-				//float z_value = Hsub_tri_e0 * p0.z + Hsub_tri_e1 * p1.z + Hsub_tri_e2 * p2.z;
-				set_pixel ( x , y , z_value , { ( GLubyte ) tex_color.x , ( GLubyte ) tex_color.y , ( GLubyte ) tex_color.z , 255 } );
+				model.meshlet_sources.push_back ( owner[ *index ] );
 			}
-			Hevaluation0 += line0.x;
-			Hevaluation1 += line1.x;
-			Hevaluation2 += line2.x;
-
-			Hsub_tri_e0 += sub_tri_e0_inc_x;
-			Hsub_tri_e1 += sub_tri_e1_inc_x;
-			Hsub_tri_e2 += sub_tri_e2_inc_x;
+		}
+		std::sort ( model.meshlet_sources.begin () + current.source_offset , model.meshlet_sources.end () );
+		model.meshlet_sources.erase ( std::unique ( model.meshlet_sources.begin () + current.source_offset , model.meshlet_sources.end () ) , model.meshlet_sources.end () );
+		current.source_cnt = static_cast< GLuint >( model.meshlet_sources.size () ) - current.source_offset;
 
+		// bounding sphere around the centre of the bounding box
+		glm::vec3 lo = model.pm[ *first ] , hi = lo;
+		for( unsigned short const* index = first ; index != last ; ++index )
+		{
+			lo = glm::min ( lo , model.pm[ *index ] );
+			hi = glm::max ( hi , model.pm[ *index ] );
+		}
+		current.center = ( lo + hi ) * 0.5f;
+		current.radius = 0.0f;
+		for( unsigned short const* index = first ; index != last ; ++index )
+		{
+			current.radius = std::max ( current.radius , glm::length ( model.pm[ *index ] - current.center ) );
 		}
-		evaluation0 += line0.y;
-		evaluation1 += line1.y;
-		evaluation2 += line2.y;
 
-		sub_tri_e0 += sub_tri_e0_inc_y;
-		sub_tri_e1 += sub_tri_e1_inc_y;
-		sub_tri_e2 += sub_tri_e2_inc_y;
+		// normal cone around the average face normal, degenerate triangles
+		// have no orientation and are culled on their own anyway
+		std::vector<glm::vec3> normals;
+		normals.reserve ( current.triangle_cnt );
+		glm::vec3 axis{ 0.0f };
+		for( unsigned short const* index = first ; index != last ; index += 3 )
+		{
+			glm::vec3 n = glm::cross ( model.pm[ index[ 1 ] ] - model.pm[ index[ 0 ] ] , model.pm[ index[ 2 ] ] - model.pm[ index[ 0 ] ] );
+			float length = glm::length ( n );
+			if( length > 0.0f )
+			{
+				normals.push_back ( n / length );
+				axis += normals.back ();
+			}
+		}
+		float const axis_length = glm::length ( axis );
+		current.cone_axis = axis_length > 0.0f ? axis / axis_length : glm::vec3{ 0.0f , 0.0f , 1.0f };
+		float min_dot = axis_length > 0.0f ? 1.0f : -1.0f;
+		for( glm::vec3 const& n : normals )
+		{
+			min_dot = std::min ( min_dot , glm::dot ( n , current.cone_axis ) );
+		}
+		// a cone wider than a hemisphere never faces away as a whole, -2 is
+		// below any dot product. Otherwise cone_cutoff = cos ( 90 + half angle )
+		// less a margin for the snapping of the triangle test
+		current.cone_cutoff = min_dot > 0.0f ? -std::sqrt ( 1.0f - min_dot * min_dot ) - cone_margin : -2.0f;
 	}
 
-	return false;
+	std::cout << name << " : " << model.meshlets.size () << " meshlets" << std::endl;
 }
 
-// render shadowmap
-bool GLPbo::render_shadow_map ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 )
+/**
+ * @brief
+ * collects every edge of Model::tri once, with the triangles on either
+ * side, for the wireframe mode. Vertices at one position, split by a uv or
+ * normal seam, are welded first so that the seams do not double the edges.
+ * @param model
+ * model whose edges are built, after optimize_mesh
+ * @param name
+ * mesh name for the report
+*/
+void GLPbo::build_edges ( Model& model , std::string const& name )
 {
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
+	size_t const vertex_cnt = model.pm.size ();
+	std::vector<GLuint> order ( vertex_cnt );
+	for( GLuint v = 0 ; v < vertex_cnt ; ++v )
+	{
+		order[ v ] = v;
+	}
+	auto position_less = [ & ] ( GLuint a , GLuint b )
 	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
+		glm::vec3 const& p = model.pm[ a ];
+		glm::vec3 const& q = model.pm[ b ];
+		return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
 	};
-	if( normal.z <= 0 )
+	std::sort ( order.begin () , order.end () , position_less );
+	std::vector<GLuint> weld ( vertex_cnt );
+	for( size_t i = 0 ; i < vertex_cnt ; ++i )
 	{
-		++culled_;
-		return false;
+		weld[ order[ i ] ] = i > 0 && model.pm[ order[ i ] ] == model.pm[ order[ i - 1 ] ] ? weld[ order[ i - 1 ] ] : order[ i ];
 	}
 
-	glm::vec3 line0 = EdgeEqnTopLeft ( p1 , p2 );
-	glm::vec3 line1 = EdgeEqnTopLeft ( p2 , p0 );
-	glm::vec3 line2 = EdgeEqnTopLeft ( p0 , p1 );
-
-	float min_x = floor ( std::min ( { p0.x, p1.x ,p2.x } ) );
-	float max_x = ceil ( std::max ( { p0.x, p1.x ,p2.x } ) );
-	float min_y = floor ( std::min ( { p0.y, p1.y ,p2.y } ) );
-	float max_y = ceil ( std::max ( { p0.y, p1.y ,p2.y } ) );
-
-	bool top_left_e0 , top_left_e1 , top_left_e2 ;
-	float evaluation0 = EvaluateFragment ( line0 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e0 );
-	float evaluation1 = EvaluateFragment ( line1 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e1 );
-	float evaluation2 = EvaluateFragment ( line2 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e2 );
-
-	float double_area_triangle = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p2.x - p0.x ) * ( p1.y - p0.y );
-
-	float sub_tri_e0 = evaluation0 / double_area_triangle;
-	float sub_tri_e1 = evaluation1 / double_area_triangle;
-	float sub_tri_e2 = evaluation2 / double_area_triangle;
-
-	float sub_tri_e0_inc_x = line0.x / double_area_triangle;
-	float sub_tri_e1_inc_x = line1.x / double_area_triangle;
-	float sub_tri_e2_inc_x = line2.x / double_area_triangle;
-
-	float sub_tri_e0_inc_y = line0.y / double_area_triangle;
-	float sub_tri_e1_inc_y = line1.y / double_area_triangle;
-	float sub_tri_e2_inc_y = line2.y / double_area_triangle;
-
-	for( int y = ( int ) min_y ; y < ( int ) max_y ; ++y )
+	// every corner as the welded edge it starts in the upper half and the
+	// corner itself in the lower, sorted so the sides of an edge meet
+	std::vector<std::uint64_t> corners;
+	corners.reserve ( model.tri.size () );
+	for( size_t t = 0 ; t < model.tri.size () ; t += 3 )
 	{
-		float Hevaluation0 = evaluation0;
-		float Hevaluation1 = evaluation1;
-		float Hevaluation2 = evaluation2;
-
-		float Hsub_tri_e0 = sub_tri_e0;
-		float Hsub_tri_e1 = sub_tri_e1;
-		float Hsub_tri_e2 = sub_tri_e2;
-
-		for( int x = ( int ) min_x ; x < ( int ) max_x ; ++x )
+		for( int k = 0 ; k < 3 ; ++k )
 		{
-			if( PointInTriangleOptimized ( Hevaluation0 , Hevaluation1 , Hevaluation2 , { x + 0.5f , y + 0.5f, 0 } , { 0,0 } , top_left_e0 , top_left_e1 , top_left_e2 ) )
+			GLuint a = weld[ model.tri[ t + k ] ] , b = weld[ model.tri[ t + ( k + 1 ) % 3 ] ];
+			if( a != b )
 			{
-				float z_value = Hsub_tri_e0 * p0.z + Hsub_tri_e1 * p1.z + Hsub_tri_e2 * p2.z;
-				float z_value_invert = 1.0f - z_value;
-				set_pixel ( x , y , z_value , { static_cast< GLubyte >( z_value_invert * 255.0f ) , static_cast< GLubyte > ( z_value_invert * 255.0f ) ,static_cast< GLubyte >( z_value_invert * 255.0f ) , 255 } );
+				std::uint64_t edge = std::min ( a , b ) << 16 | std::max ( a , b );
+				corners.push_back ( edge << 32 | ( t + k ) );
 			}
-			Hevaluation0 += line0.x;
-			Hevaluation1 += line1.x;
-			Hevaluation2 += line2.x;
-
-			Hsub_tri_e0 += sub_tri_e0_inc_x;
-			Hsub_tri_e1 += sub_tri_e1_inc_x;
-			Hsub_tri_e2 += sub_tri_e2_inc_x;
-
 		}
-		evaluation0 += line0.y;
-		evaluation1 += line1.y;
-		evaluation2 += line2.y;
-
-		sub_tri_e0 += sub_tri_e0_inc_y;
-		sub_tri_e1 += sub_tri_e1_inc_y;
-		sub_tri_e2 += sub_tri_e2_inc_y;
 	}
+	std::sort ( corners.begin () , corners.end () );
 
-	return false;
+	// sides are paired up in order, an edge of more than two triangles
+	// becomes several
+	model.edges.clear ();
+	size_t borders = 0;
+	for( size_t i = 0 ; i < corners.size () ; )
+	{
+		size_t j = i + 1;
+		while( j < corners.size () && corners[ j ] >> 32 == corners[ i ] >> 32 )
+		{
+			++j;
+		}
+		for( ; i < j ; i += 2 )
+		{
+			GLuint face1 = i + 1 < j ? static_cast< GLuint >( corners[ i + 1 ] ) : no_face;
+			borders += face1 == no_face;
+			model.edges.push_back ( { static_cast< GLuint >( corners[ i ] ) , face1 } );
+		}
+		i = j;
+	}
+	std::cout << name << " : " << model.edges.size () << " edges , " << borders << " on borders" << std::endl;
 }
 
-// render point light
-bool GLPbo::render_point_light ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Model& model , int index0 , int index1 , int index2 )
+/**
+ * @brief
+ * culls whole meshlets for the view of the vertex stage, a meshlet is
+ * dropped when its bounding sphere is beyond a viewport side or its normal
+ * cone faces away from the viewer. Both tests are conservative, a dropped
+ * meshlet only has triangles cull_range would drop too.
+ * @param model
+ * model whose visible_meshlets is rebuilt
+ * @param rotation
+ * model transform
+ * @param scale , offset
+ * the viewport transform, window = scale * p + offset
+*/
+void GLPbo::cull_meshlets ( Model& model , glm::mat3 const& rotation , glm::vec3 const& scale , glm::vec3 const& offset )
 {
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
+	// the projection is orthographic along z, so the viewer direction in
+	// model space is the same for every meshlet
+	glm::vec3 const view{ rotation[ 0 ][ 2 ] , rotation[ 1 ][ 2 ] , rotation[ 2 ][ 2 ] };
+	float const w = static_cast< float >( width );
+	float const h = static_cast< float >( height );
+
+	model.visible_meshlets.clear ();
+	for( GLuint m = 0 ; m < model.meshlets.size () ; ++m )
 	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
-	};
-	if( normal.z <= 0 )
-	{
-		++culled_;
-		return false;
+		Meshlet const& meshlet = model.meshlets[ m ];
+		if( glm::dot ( meshlet.cone_axis , view ) < meshlet.cone_cutoff )
+		{
+			continue;
+		}
+		// one pixel of slack covers the rounding of the vertex transform
+		glm::vec3 center = scale * ( rotation * meshlet.center ) + offset;
+		float rx = meshlet.radius * scale.x + 1.0f , ry = meshlet.radius * scale.y + 1.0f;
+		if( center.x + rx < 0 || center.x - rx >= w || center.y + ry < 0 || center.y - ry >= h )
+		{
+			continue;
+		}
+		model.visible_meshlets.push_back ( m );
 	}
+}
 
-	glm::vec3 line0 = EdgeEqnTopLeft ( p1 , p2 );
-	glm::vec3 line1 = EdgeEqnTopLeft ( p2 , p0 );
-	glm::vec3 line2 = EdgeEqnTopLeft ( p0 , p1 );
+/*
+Quadric error metric of the level of detail builder ( Garland & Heckbert ).
+Sum of area weighted squared distances to a set of planes, kept as the
+symmetric matrix A, the vector b and the scalar c of p'Ap + 2b'p + c, and
+the total weight w the sum is divided by.
+*/
+struct Quadric
+{
+	double a00 , a11 , a22 , a10 , a20 , a21;
+	double b0 , b1 , b2 , c;
+	double w;
 
-	float min_x = floor ( std::min ( { p0.x, p1.x ,p2.x } ) );
-	float max_x = ceil ( std::max ( { p0.x, p1.x ,p2.x } ) );
-	float min_y = floor ( std::min ( { p0.y, p1.y ,p2.y } ) );
-	float max_y = ceil ( std::max ( { p0.y, p1.y ,p2.y } ) );
+	// plane through p with unit normal n
+	static Quadric plane ( glm::vec3 const& n , glm::vec3 const& p , double weight )
+	{
+		double d = -glm::dot ( n , p );
+		return { weight * n.x * n.x , weight * n.y * n.y , weight * n.z * n.z ,
+			weight * n.y * n.x , weight * n.z * n.x , weight * n.z * n.y ,
+			weight * d * n.x , weight * d * n.y , weight * d * n.z , weight * d * d , weight };
+	}
 
-	bool top_left_e0 , top_left_e1 , top_left_e2 ;
-	float evaluation0 = EvaluateFragment ( line0 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e0 );
-	float evaluation1 = EvaluateFragment ( line1 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e1 );
-	float evaluation2 = EvaluateFragment ( line2 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e2 );
+	Quadric& operator+= ( Quadric const& q )
+	{
+		a00 += q.a00; a11 += q.a11; a22 += q.a22; a10 += q.a10; a20 += q.a20; a21 += q.a21;
+		b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c; w += q.w;
+		return *this;
+	}
 
-	float double_area_triangle = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p2.x - p0.x ) * ( p1.y - p0.y );
+	// mean squared distance of p to the planes
+	double error ( glm::vec3 const& p ) const
+	{
+		double x = p.x , y = p.y , z = p.z;
+		double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * ( a10 * x * y + a20 * x * z + a21 * y * z ) +
+			2.0 * ( b0 * x + b1 * y + b2 * z ) + c;
+		return w > 0.0 ? std::max ( e , 0.0 ) / w : 0.0;
+	}
+};
 
-	float sub_tri_e0 = evaluation0 / double_area_triangle;
-	float sub_tri_e1 = evaluation1 / double_area_triangle;
-	float sub_tri_e2 = evaluation2 / double_area_triangle;
+/**
+ * @brief
+ * builds the level of detail chain of a model by quadric error edge
+ * collapses. Every collapse moves a vertex onto a neighbour, so the
+ * surviving vertices keep their own normals and uvs, and the cost adds the
+ * attribute difference to the geometric error. Vertices on open borders
+ * and on seams, where one position has several normals or uvs, never move,
+ * which keeps the levels free of cracks. The collapses run in passes, each
+ * applying the cheapest ones that do not touch one another, and a level is
+ * kept every time the triangle count halves.
+ * @param model
+ * optimized model to simplify, it is not changed
+ * @param name
+ * mesh name for the report
+ * @param lods
+ * receives the levels, each optimized and cut into meshlets
+*/
+void GLPbo::build_lods ( Model const& model , std::string const& name , std::vector<Model>& lods )
+{
+	lods.clear ();
+	size_t const vertex_cnt = model.pm.size ();
+	if( model.tri.empty () )
+	{
+		return;
+	}
+	bool const has_nml = model.nml.size () == vertex_cnt;
+	bool const has_tex = model.tex.size () == vertex_cnt;
 
-	float sub_tri_e0_inc_x = line0.x / double_area_triangle;
-	float sub_tri_e1_inc_x = line1.x / double_area_triangle;
-	float sub_tri_e2_inc_x = line2.x / double_area_triangle;
+	// positions in the unit cube, so the weights do not depend on the mesh scale
+	glm::vec3 lo = model.pm[ 0 ] , hi = lo;
+	for( glm::vec3 const& p : model.pm )
+	{
+		lo = glm::min ( lo , p );
+		hi = glm::max ( hi , p );
+	}
+	float const extent = std::max ( { hi.x - lo.x , hi.y - lo.y , hi.z - lo.z } );
+	if( extent <= 0.0f )
+	{
+		return;
+	}
+	std::vector<glm::vec3> pos ( vertex_cnt );
+	for( size_t v = 0 ; v < vertex_cnt ; ++v )
+	{
+		pos[ v ] = ( model.pm[ v ] - lo ) / extent;
+	}
 
-	float sub_tri_e0_inc_y = line0.y / double_area_triangle;
-	float sub_tri_e1_inc_y = line1.y / double_area_triangle;
-	float sub_tri_e2_inc_y = line2.y / double_area_triangle;
+	std::vector<unsigned short> tri = model.tri;
+	std::vector<Quadric> quadric ( vertex_cnt , Quadric{} );
+	for( size_t t = 0 ; t < tri.size () ; t += 3 )
+	{
+		glm::vec3 n = glm::cross ( pos[ tri[ t + 1 ] ] - pos[ tri[ t ] ] , pos[ tri[ t + 2 ] ] - pos[ tri[ t ] ] );
+		float area = glm::length ( n );
+		if( area > 0.0f )
+		{
+			Quadric q = Quadric::plane ( n / area , pos[ tri[ t ] ] , area * 0.5 );
+			for( int k = 0 ; k < 3 ; ++k )
+			{
+				quadric[ tri[ t + k ] ] += q;
+			}
+		}
+	}
 
-	for( int y = ( int ) min_y ; y < ( int ) max_y ; ++y )
+	// seams, several vertices at one position
+	std::vector<char> locked ( vertex_cnt , 0 );
+	std::vector<GLuint> order ( vertex_cnt );
+	for( GLuint v = 0 ; v < vertex_cnt ; ++v )
+	{
+		order[ v ] = v;
+	}
+	auto position_less = [ & ] ( GLuint a , GLuint b )
+	{
+		glm::vec3 const& p = model.pm[ a ];
+		glm::vec3 const& q = model.pm[ b ];
+		return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+	};
+	std::sort ( order.begin () , order.end () , position_less );
+	for( size_t i = 1 ; i < vertex_cnt ; ++i )
+	{
+		if( model.pm[ order[ i ] ] == model.pm[ order[ i - 1 ] ] )
+		{
+			locked[ order[ i ] ] = locked[ order[ i - 1 ] ] = 1;
+		}
+	}
+	// open borders, edges used by a single triangle
+	std::vector<GLuint> edges;
+	edges.reserve ( tri.size () );
+	for( size_t t = 0 ; t < tri.size () ; t += 3 )
+	{
+		for( int k = 0 ; k < 3 ; ++k )
+		{
+			GLuint a = tri[ t + k ] , b = tri[ t + ( k + 1 ) % 3 ];
+			edges.push_back ( std::min ( a , b ) << 16 | std::max ( a , b ) );
+		}
+	}
+	std::sort ( edges.begin () , edges.end () );
+	for( size_t i = 0 ; i < edges.size () ; )
 	{
-		float Hevaluation0 = evaluation0;
-		float Hevaluation1 = evaluation1;
-		float Hevaluation2 = evaluation2;
+		size_t j = i + 1;
+		while( j < edges.size () && edges[ j ] == edges[ i ] )
+		{
+			++j;
+		}
+		if( j - i == 1 )
+		{
+			locked[ edges[ i ] >> 16 ] = locked[ edges[ i ] & 0xffff ] = 1;
+		}
+		i = j;
+	}
 
-		float Hsub_tri_e0 = sub_tri_e0;
-		float Hsub_tri_e1 = sub_tri_e1;
-		float Hsub_tri_e2 = sub_tri_e2;
+	struct Collapse
+	{
+		double cost;
+		GLuint from , to;
+		double error;
+	};
+	std::vector<Collapse> collapses;
+	std::vector<int> first ( vertex_cnt + 1 ) , adjacency;
+	std::vector<GLuint> remap ( vertex_cnt );
+	std::vector<char> touched ( vertex_cnt );
+	std::vector<GLuint> ring;
+	double error = 0.0;
+	size_t target = tri.size () / 3;
+
+	for( int level = 1 ; level <= lod_levels ; ++level )
+	{
+		size_t const previous = tri.size () / 3;
+		target /= 2;
+		if( target < lod_min_triangles )
+		{
+			break;
+		}
 
-		for( int x = ( int ) min_x ; x < ( int ) max_x ; ++x )
+		while( tri.size () / 3 > target )
 		{
-			if( PointInTriangleOptimized ( Hevaluation0 , Hevaluation1 , Hevaluation2 , { x + 0.5f , y + 0.5f, 0 } , { 0,0 } , top_left_e0 , top_left_e1 , top_left_e2 ) )
+			size_t const triangle_cnt = tri.size () / 3;
+
+			// triangles using each vertex
+			std::fill ( first.begin () , first.end () , 0 );
+			for( unsigned short index : tri )
+			{
+				++first[ index + 1 ];
+			}
+			for( size_t v = 0 ; v < vertex_cnt ; ++v )
+			{
+				first[ v + 1 ] += first[ v ];
+			}
+			adjacency.resize ( tri.size () );
+			std::vector<int> filled ( first.begin () , first.end () - 1 );
+			for( size_t t = 0 ; t < triangle_cnt ; ++t )
+			{
+				for( int k = 0 ; k < 3 ; ++k )
+				{
+					adjacency[ filled[ tri[ t * 3 + k ] ]++ ] = static_cast< int >( t );
+				}
+			}
+
+			// cheaper direction of every edge, interior edges show up once with a < b
+			collapses.clear ();
+			for( size_t t = 0 ; t < tri.size () ; t += 3 )
+			{
+				for( int k = 0 ; k < 3 ; ++k )
+				{
+					GLuint a = tri[ t + k ] , b = tri[ t + ( k + 1 ) % 3 ];
+					if( a >= b )
+					{
+						continue;
+					}
+					Collapse best{ -1.0 , 0 , 0 , 0.0 };
+					for( int direction = 0 ; direction < 2 ; ++direction )
+					{
+						GLuint from = direction ? b : a , to = direction ? a : b;
+						if( locked[ from ] )
+						{
+							continue;
+						}
+						Quadric q = quadric[ from ];
+						q += quadric[ to ];
+						double geometric = q.error ( pos[ to ] );
+						double attribute = 0.0;
+						if( has_nml )
+						{
+							glm::vec3 d = model.nml[ from ] - model.nml[ to ];
+							attribute += glm::dot ( d , d );
+						}
+						if( has_tex )
+						{
+							glm::vec2 d = model.tex[ from ] - model.tex[ to ];
+							attribute += glm::dot ( d , d );
+						}
+						double cost = geometric + lod_attribute_weight * lod_attribute_weight * attribute;
+						if( best.cost < 0.0 || cost < best.cost )
+						{
+							best = { cost , from , to , std::sqrt ( geometric ) };
+						}
+					}
+					if( best.cost >= 0.0 )
+					{
+						collapses.push_back ( best );
+					}
+				}
+			}
+			std::sort ( collapses.begin () , collapses.end () , [] ( Collapse const& a , Collapse const& b ) { return a.cost < b.cost; } );
+
+			// costs are not updated within a pass, so only its cheaper half is used
+			for( size_t v = 0 ; v < vertex_cnt ; ++v )
+			{
+				remap[ v ] = static_cast< GLuint >( v );
+			}
+			std::fill ( touched.begin () , touched.end () , 0 );
+			size_t removed = 0;
+			size_t const pass_limit = collapses.size () / 2 + 1;
+			for( size_t i = 0 ; i < collapses.size () && i < pass_limit && triangle_cnt - removed > target ; ++i )
+			{
+				Collapse const& collapse = collapses[ i ];
+				GLuint from = collapse.from , to = collapse.to;
+				if( touched[ from ] || touched[ to ] )
+				{
+					continue;
+				}
+
+				// the neighbours both share must be exactly the ones opposite the
+				// edge, and no triangle moving with from may flip
+				ring.clear ();
+				int shared_triangles = 0;
+				bool flips = false;
+				for( int a = first[ from ] ; a < first[ from + 1 ] ; ++a )
+				{
+					unsigned short const* corner = &tri[ adjacency[ a ] * 3 ];
+					bool has_to = corner[ 0 ] == to || corner[ 1 ] == to || corner[ 2 ] == to;
+					shared_triangles += has_to;
+					for( int k = 0 ; k < 3 ; ++k )
+					{
+						if( corner[ k ] != from && corner[ k ] != to )
+						{
+							ring.push_back ( corner[ k ] );
+						}
+					}
+					if( !has_to )
+					{
+						glm::vec3 p[ 3 ] , q[ 3 ];
+						for( int k = 0 ; k < 3 ; ++k )
+						{
+							p[ k ] = pos[ corner[ k ] ];
+							q[ k ] = corner[ k ] == from ? pos[ to ] : p[ k ];
+						}
+						if( glm::dot ( glm::cross ( p[ 1 ] - p[ 0 ] , p[ 2 ] - p[ 0 ] ) , glm::cross ( q[ 1 ] - q[ 0 ] , q[ 2 ] - q[ 0 ] ) ) <= 0.0f )
+						{
+							flips = true;
+						}
+					}
+				}
+				if( flips )
+				{
+					continue;
+				}
+				std::sort ( ring.begin () , ring.end () );
+				ring.erase ( std::unique ( ring.begin () , ring.end () ) , ring.end () );
+				int shared_neighbours = 0;
+				for( GLuint v : ring )
+				{
+					for( int a = first[ to ] ; a < first[ to + 1 ] ; ++a )
+					{
+						unsigned short const* corner = &tri[ adjacency[ a ] * 3 ];
+						if( corner[ 0 ] == v || corner[ 1 ] == v || corner[ 2 ] == v )
+						{
+							++shared_neighbours;
+							break;
+						}
+					}
+				}
+				if( shared_neighbours != shared_triangles )
+				{
+					continue;
+				}
+
+				remap[ from ] = to;
+				quadric[ to ] += quadric[ from ];
+				error = std::max ( error , collapse.error );
+				removed += shared_triangles;
+				touched[ from ] = touched[ to ] = 1;
+				for( GLuint v : ring )
+				{
+					touched[ v ] = 1;
+				}
+			}
+			if( removed == 0 )
 			{
-				float z_value = Hsub_tri_e0 * p0.z + Hsub_tri_e1 * p1.z + Hsub_tri_e2 * p2.z;
-				glm::vec3 tri_point = Hsub_tri_e0 * model.pm[ index0 ] + Hsub_tri_e1 * model.pm[ index1 ] + Hsub_tri_e2 * model.pm[ index2 ];
-				glm::vec3 tri_normal = Hsub_tri_e0 * model.nml[ index0 ] + Hsub_tri_e1 * model.nml[ index1 ] + Hsub_tri_e2 * model.nml[ index2 ];
-				float light = Calculate_Light ( point_light , tri_point , tri_normal );
-				set_pixel ( x , y , z_value , { static_cast< GLubyte >( light * 255.0f ) , static_cast< GLubyte > ( light * 255.0f ) ,static_cast< GLubyte >( light * 255.0f ) , 255 } );
+				break;
 			}
-			Hevaluation0 += line0.x;
-			Hevaluation1 += line1.x;
-			Hevaluation2 += line2.x;
 
-			Hsub_tri_e0 += sub_tri_e0_inc_x;
-			Hsub_tri_e1 += sub_tri_e1_inc_x;
-			Hsub_tri_e2 += sub_tri_e2_inc_x;
+			// apply the pass and drop the triangles that collapsed
+			size_t kept = 0;
+			for( size_t t = 0 ; t < tri.size () ; t += 3 )
+			{
+				unsigned short a = static_cast< unsigned short >( remap[ tri[ t ] ] );
+				unsigned short b = static_cast< unsigned short >( remap[ tri[ t + 1 ] ] );
+				unsigned short c = static_cast< unsigned short >( remap[ tri[ t + 2 ] ] );
+				if( a != b && b != c && c != a )
+				{
+					tri[ kept++ ] = a;
+					tri[ kept++ ] = b;
+					tri[ kept++ ] = c;
+				}
+			}
+			tri.resize ( kept );
+		}
 
+		// a level must be worth its memory
+		if( tri.size () / 3 > previous * 9 / 10 )
+		{
+			break;
 		}
-		evaluation0 += line0.y;
-		evaluation1 += line1.y;
-		evaluation2 += line2.y;
+		Model lod;
+		lod.pm = model.pm;
+		lod.nml = model.nml;
+		lod.tex = model.tex;
+		lod.tri = tri;
+		lod.lod_error = static_cast< float >( error ) * extent;
+		std::string lod_name = name + " lod " + std::to_string ( level );
+		optimize_mesh ( lod , lod_name );
+		build_meshlets ( lod , lod_name );
+		build_edges ( lod , lod_name );
+		std::cout << lod_name << " : " << lod.tri.size () / 3 << " triangles , error " << lod.lod_error << std::endl;
+		lods.push_back ( std::move ( lod ) );
+	}
+}
 
-		sub_tri_e0 += sub_tri_e0_inc_y;
-		sub_tri_e1 += sub_tri_e1_inc_y;
-		sub_tri_e2 += sub_tri_e2_inc_y;
+/**
+ * @brief
+ * picks the level of detail of a model for the current viewport. The
+ * viewport maps model units to at most half the window's larger side in
+ * pixels, and the coarsest level whose error stays within lod_pixel_error
+ * pixels there is used.
+ * @param index
+ * index of the model in all_model_data
+ * @return
+ * the model itself or one of its levels in all_model_lods
+*/
+GLPbo::Model& GLPbo::select_lod ( int index )
+{
+	std::vector<Model>& lods = all_model_lods[ index ];
+	float const pixels = std::max ( width , height ) / 2.0f;
+	lod_level = 0;
+	while( lod_level < static_cast< int >( lods.size () ) && lods[ lod_level ].lod_error * pixels <= lod_pixel_error )
+	{
+		++lod_level;
 	}
+	return lod_level ? lods[ lod_level - 1 ] : all_model_data[ index ].second;
+}
 
-	return false;
+/**
+ * @brief
+ * transforms a range of vertices, several at a time, from pm_x , pm_y and
+ * pm_z into pd. The sums are formed in the same order as the glm matrix
+ * products they replace, so pd is bit-identical to the scalar transform.
+ * @param model
+ * model to transform
+ * @param begin , end
+ * range of vertices
+ * @param rotation
+ * model transform
+ * @param scale , offset
+ * the viewport transform, window = scale * p + offset
+*/
+void GLPbo::transform_vertices ( Model& model , size_t begin , size_t end , glm::mat3 const& rotation , glm::vec3 const& scale , glm::vec3 const& offset )
+{
+	float const* px = model.pm_x.data ();
+	float const* py = model.pm_y.data ();
+	float const* pz = model.pm_z.data ();
+	glm::vec3* pd = model.pd.data ();
+	size_t i = begin;
+
+#if defined( GLPBO_AVX2 ) || defined( GLPBO_SSE2 )
+#if defined( GLPBO_AVX2 )
+	constexpr size_t lanes = 8;
+	using vec = __m256;
+#define VLOAD _mm256_loadu_ps
+#define VSET _mm256_set1_ps
+#define VADD _mm256_add_ps
+#define VMUL _mm256_mul_ps
+#define VSTORE _mm256_store_ps
+#else
+	constexpr size_t lanes = 4;
+	using vec = __m128;
+#define VLOAD _mm_loadu_ps
+#define VSET _mm_set1_ps
+#define VADD _mm_add_ps
+#define VMUL _mm_mul_ps
+#define VSTORE _mm_store_ps
+#endif
+	vec m[ 3 ][ 3 ];
+	for( int c = 0 ; c < 3 ; ++c )
+	{
+		for( int r = 0 ; r < 3 ; ++r )
+		{
+			m[ c ][ r ] = VSET ( rotation[ c ][ r ] );
+		}
+	}
+	vec const s[ 3 ] = { VSET ( scale.x ) , VSET ( scale.y ) , VSET ( scale.z ) };
+	vec const o[ 3 ] = { VSET ( offset.x ) , VSET ( offset.y ) , VSET ( offset.z ) };
+
+	for( ; i + lanes <= end ; i += lanes )
+	{
+		vec x = VLOAD ( px + i );
+		vec y = VLOAD ( py + i );
+		vec z = VLOAD ( pz + i );
+		alignas( 32 ) float out[ 3 ][ lanes ];
+		for( int r = 0 ; r < 3 ; ++r )
+		{
+			vec rotated = VADD ( VADD ( VMUL ( m[ 0 ][ r ] , x ) , VMUL ( m[ 1 ][ r ] , y ) ) , VMUL ( m[ 2 ][ r ] , z ) );
+			VSTORE ( out[ r ] , VADD ( VMUL ( s[ r ] , rotated ) , o[ r ] ) );
+		}
+		for( size_t k = 0 ; k < lanes ; ++k )
+		{
+			pd[ i + k ] = { out[ 0 ][ k ] , out[ 1 ][ k ] , out[ 2 ][ k ] };
+		}
+	}
+#undef VLOAD
+#undef VSET
+#undef VADD
+#undef VMUL
+#undef VSTORE
+#endif
+
+	for( ; i < end ; ++i )
+	{
+		glm::vec3 rotated = rotation * glm::vec3 ( px[ i ] , py[ i ] , pz[ i ] );
+		pd[ i ] = scale * rotated + offset;
+	}
+}
+
+/**
+ * @brief
+ * culling pre-pass over the triangles of the meshlets kept by the vertex
+ * stage. Jobs of up to cull_batch triangles run on the thread pool, each
+ * into its own list, and the lists are joined in order into
+ * visible_triangles.
+ * @param model
+ * model whose window coordinates pd are already up to date
+*/
+void GLPbo::cull_triangles ( Model const& model )
+{
+	GLPBO_TRACE_SCOPE ( "cull" );
+
+	// triangles of the meshlets rejected by the vertex stage count as culled
+	size_t count = model.tri.size () / 3;
+	size_t kept = 0;
+	cull_ranges.clear ();
+	for( GLuint m : model.visible_meshlets )
+	{
+		size_t begin = model.meshlets[ m ].triangle_offset , end = begin + model.meshlets[ m ].triangle_cnt;
+		kept += end - begin;
+		if( !cull_ranges.empty () && cull_ranges.back ().second == begin && cull_ranges.back ().second - cull_ranges.back ().first < static_cast< size_t >( cull_batch ) )
+		{
+			begin = cull_ranges.back ().first;
+			cull_ranges.pop_back ();
+		}
+		for( ; end - begin > static_cast< size_t >( cull_batch ) ; begin += cull_batch )
+		{
+			cull_ranges.emplace_back ( begin , begin + cull_batch );
+		}
+		cull_ranges.emplace_back ( begin , end );
+	}
+
+	int batches = static_cast< int >( cull_ranges.size () );
+	if( batch_visible.size () < cull_ranges.size () )
+	{
+		batch_visible.resize ( batches );
+		batch_culled.resize ( batches );
+	}
+
+	thread_pool.parallel_for ( batches , [ & ] ( int batch , int )
+	{
+		GLPBO_TRACE_SCOPE ( "cull batch" );
+		batch_visible[ batch ].clear ();
+		batch_culled[ batch ] = cull_range ( model , cull_ranges[ batch ].first , cull_ranges[ batch ].second , batch_visible[ batch ] );
+	} );
+
+	PipelineStatistics& statistics = ThreadStatistics ();
+	visible_triangles.clear ();
+	for( int batch = 0 ; batch < batches ; ++batch )
+	{
+		visible_triangles.insert ( visible_triangles.end () , batch_visible[ batch ].begin () , batch_visible[ batch ].end () );
+		statistics.culled += batch_culled[ batch ];
+	}
+	statistics.culled += count - kept;
+	statistics.primitives += count;
+	// counted here as viewport_transform skips the frames pd is reused for
+	statistics.vertices += model.visible_vertices;
 }
 
-// render texture point light
-bool GLPbo::render_texture_point_light ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Model& model , int index0 , int index1 , int index2 , glm::vec2 texture0 , glm::vec2 texture1 , glm::vec2 texture2 )
+/**
+ * @brief
+ * culls a range of triangles, several at a time. A triangle is dropped when
+ * all three vertices lie beyond the same viewport side, or when it is within
+ * the guard band and its area on the sub-pixel grid is not positive, the
+ * exact test SetupEdges applies. Triangles reaching past the guard band are
+ * kept, clip_triangle decides about them.
+ * @param model
+ * model the triangles belong to
+ * @param begin , end
+ * range of triangles ( not indices )
+ * @param visible
+ * offsets into Model::tri of the triangles kept are appended to it
+ * @return
+ * number of triangles culled
+*/
+unsigned int GLPbo::cull_range ( Model const& model , size_t begin , size_t end , std::vector<GLuint>& visible )
 {
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
+	unsigned int culled = 0;
+	size_t t = begin;
+
+#if defined( GLPBO_AVX2 ) || defined( GLPBO_SSE2 )
+	// snapped coordinates and their products are exact in double within the
+	// guard band, so the area test matches the int64 one in SetupEdges
+#if defined( GLPBO_AVX2 )
+	constexpr size_t lanes = 4;
+	using vec = __m256d;
+#define VLOAD _mm256_load_pd
+#define VSET _mm256_set1_pd
+#define VADD _mm256_add_pd
+#define VSUB _mm256_sub_pd
+#define VMUL _mm256_mul_pd
+#define VMIN _mm256_min_pd
+#define VMAX _mm256_max_pd
+#define VAND _mm256_and_pd
+#define VOR _mm256_or_pd
+#define VLT( a , b ) _mm256_cmp_pd ( a , b , _CMP_LT_OQ )
+#define VLE( a , b ) _mm256_cmp_pd ( a , b , _CMP_LE_OQ )
+#define VMASK _mm256_movemask_pd
+	auto snap = [] ( vec v ) { return _mm256_floor_pd ( _mm256_add_pd ( _mm256_mul_pd ( v , _mm256_set1_pd ( double ( subpixel_one ) ) ) , _mm256_set1_pd ( 0.5 ) ) ); };
+#else
+	constexpr size_t lanes = 2;
+	using vec = __m128d;
+#define VLOAD _mm_load_pd
+#define VSET _mm_set1_pd
+#define VADD _mm_add_pd
+#define VSUB _mm_sub_pd
+#define VMUL _mm_mul_pd
+#define VMIN _mm_min_pd
+#define VMAX _mm_max_pd
+#define VAND _mm_and_pd
+#define VOR _mm_or_pd
+#define VLT( a , b ) _mm_cmplt_pd ( a , b )
+#define VLE( a , b ) _mm_cmple_pd ( a , b )
+#define VMASK _mm_movemask_pd
+	// SSE2 has no floor: round to nearest with the 2^52 + 2^51 trick, then
+	// step down where that rounded up. Exact for the magnitudes in the band
+	auto snap = [] ( vec v )
 	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
+		__m128d const magic = _mm_set1_pd ( 6755399441055744.0 );
+		__m128d x = _mm_add_pd ( _mm_mul_pd ( v , _mm_set1_pd ( double ( subpixel_one ) ) ) , _mm_set1_pd ( 0.5 ) );
+		__m128d r = _mm_sub_pd ( _mm_add_pd ( x , magic ) , magic );
+		return _mm_sub_pd ( r , _mm_and_pd ( _mm_cmpgt_pd ( r , x ) , _mm_set1_pd ( 1.0 ) ) );
 	};
-	if( normal.z <= 0 )
+#endif
+	vec const zero = VSET ( 0.0 );
+	vec const w = VSET ( width );
+	vec const h = VSET ( height );
+	vec const band_lo = VSET ( -guard_band );
+	vec const band_x = VSET ( width + guard_band );
+	vec const band_y = VSET ( height + guard_band );
+
+	for( ; t + lanes <= end ; t += lanes )
 	{
-		++culled_;
-		return false;
+		// gather the triangles' vertices into one register per coordinate
+		alignas( 32 ) double coord[ 6 ][ lanes ];
+		for( size_t k = 0 ; k < lanes ; ++k )
+		{
+			for( int v = 0 ; v < 3 ; ++v )
+			{
+				glm::vec3 const& p = model.pd[ model.tri[ ( t + k ) * 3 + v ] ];
+				coord[ v * 2 ][ k ] = p.x;
+				coord[ v * 2 + 1 ][ k ] = p.y;
+			}
+		}
+		vec x0 = VLOAD ( coord[ 0 ] ) , y0 = VLOAD ( coord[ 1 ] );
+		vec x1 = VLOAD ( coord[ 2 ] ) , y1 = VLOAD ( coord[ 3 ] );
+		vec x2 = VLOAD ( coord[ 4 ] ) , y2 = VLOAD ( coord[ 5 ] );
+
+		vec min_x = VMIN ( x0 , VMIN ( x1 , x2 ) ) , max_x = VMAX ( x0 , VMAX ( x1 , x2 ) );
+		vec min_y = VMIN ( y0 , VMIN ( y1 , y2 ) ) , max_y = VMAX ( y0 , VMAX ( y1 , y2 ) );
+		vec outside = VOR ( VOR ( VLT ( max_x , zero ) , VLE ( w , min_x ) ) , VOR ( VLT ( max_y , zero ) , VLE ( h , min_y ) ) );
+		vec in_band = VAND ( VAND ( VLE ( band_lo , min_x ) , VLE ( max_x , band_x ) ) , VAND ( VLE ( band_lo , min_y ) , VLE ( max_y , band_y ) ) );
+
+		vec X0 = snap ( x0 ) , Y0 = snap ( y0 );
+		vec X1 = snap ( x1 ) , Y1 = snap ( y1 );
+		vec X2 = snap ( x2 ) , Y2 = snap ( y2 );
+		vec area = VSUB ( VMUL ( VSUB ( X1 , X0 ) , VSUB ( Y2 , Y0 ) ) , VMUL ( VSUB ( X2 , X0 ) , VSUB ( Y1 , Y0 ) ) );
+		vec back = VAND ( in_band , VLE ( area , zero ) );
+
+		unsigned int drop = static_cast< unsigned int >( VMASK ( VOR ( outside , back ) ) );
+		for( size_t k = 0 ; k < lanes ; ++k )
+		{
+			if( drop & ( 1u << k ) )
+			{
+				++culled;
+			}
+			else
+			{
+				visible.push_back ( static_cast< GLuint >( ( t + k ) * 3 ) );
+			}
+		}
+	}
+#undef VLOAD
+#undef VSET
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VMIN
+#undef VMAX
+#undef VAND
+#undef VOR
+#undef VLT
+#undef VLE
+#undef VMASK
+#endif
+
+	float const w_f = static_cast< float >( width );
+	float const h_f = static_cast< float >( height );
+	for( ; t < end ; ++t )
+	{
+		glm::vec3 const& p0 = model.pd[ model.tri[ t * 3 ] ];
+		glm::vec3 const& p1 = model.pd[ model.tri[ t * 3 + 1 ] ];
+		glm::vec3 const& p2 = model.pd[ model.tri[ t * 3 + 2 ] ];
+
+		// trivial reject, all three vertices beyond the same viewport side
+		if( ( p0.x < 0 && p1.x < 0 && p2.x < 0 ) || ( p0.x >= w_f && p1.x >= w_f && p2.x >= w_f ) ||
+			( p0.y < 0 && p1.y < 0 && p2.y < 0 ) || ( p0.y >= h_f && p1.y >= h_f && p2.y >= h_f ) )
+		{
+			++culled;
+			continue;
+		}
+
+		float min_x = std::min ( { p0.x , p1.x , p2.x } ) , max_x = std::max ( { p0.x , p1.x , p2.x } );
+		float min_y = std::min ( { p0.y , p1.y , p2.y } ) , max_y = std::max ( { p0.y , p1.y , p2.y } );
+		if( min_x >= -guard_band && max_x <= w_f + guard_band && min_y >= -guard_band && max_y <= h_f + guard_band )
+		{
+			std::int64_t X0 = SnapToSubpixel ( p0.x ) , Y0 = SnapToSubpixel ( p0.y );
+			std::int64_t X1 = SnapToSubpixel ( p1.x ) , Y1 = SnapToSubpixel ( p1.y );
+			std::int64_t X2 = SnapToSubpixel ( p2.x ) , Y2 = SnapToSubpixel ( p2.y );
+			if( ( X1 - X0 ) * ( Y2 - Y0 ) - ( X2 - X0 ) * ( Y1 - Y0 ) <= 0 )
+			{
+				++culled;
+				continue;
+			}
+		}
+		visible.push_back ( static_cast< GLuint >( t * 3 ) );
+	}
+	return culled;
+}
+
+/**
+ * @brief
+ * binning front end. Triangles from the culling pre-pass that reach past
+ * the guard band are clipped, and every triangle is appended to the bin of
+ * each tile its bounding box overlaps. Bins keep submission order, so the
+ * depth test resolves ties exactly as a single pass over Model::tri would.
+ * @param model
+ * model whose window coordinates pd are already up to date
+*/
+void GLPbo::bin_triangles ( Model const& model )
+{
+	GLPBO_TRACE_SCOPE ( "bin" );
+	for( std::vector<GLuint>& bin : tile_bins )
+	{
+		bin.clear ();
 	}
+	clipped_triangles.clear ();
+
+	float const w = static_cast< float >( width );
+	float const h = static_cast< float >( height );
+
+	for( GLuint i : visible_triangles )
+	{
+		glm::vec3 const& p0 = model.pd[ model.tri[ i ] ];
+		glm::vec3 const& p1 = model.pd[ model.tri[ i + 1 ] ];
+		glm::vec3 const& p2 = model.pd[ model.tri[ i + 2 ] ];
 
-	glm::vec3 line0 = EdgeEqnTopLeft ( p1 , p2 );
-	glm::vec3 line1 = EdgeEqnTopLeft ( p2 , p0 );
-	glm::vec3 line2 = EdgeEqnTopLeft ( p0 , p1 );
+		float min_x = std::min ( { p0.x , p1.x , p2.x } ) , max_x = std::max ( { p0.x , p1.x , p2.x } );
+		float min_y = std::min ( { p0.y , p1.y , p2.y } ) , max_y = std::max ( { p0.y , p1.y , p2.y } );
+		if( !( min_x >= -guard_band && max_x <= w + guard_band && min_y >= -guard_band && max_y <= h + guard_band ) )
+		{
+			clip_triangle ( model , i );
+			continue;
+		}
+
+		bin_bounds ( p0 , p1 , p2 , i );
+	}
+}
 
-	float min_x = floor ( std::min ( { p0.x, p1.x ,p2.x } ) );
-	float max_x = ceil ( std::max ( { p0.x, p1.x ,p2.x } ) );
-	float min_y = floor ( std::min ( { p0.y, p1.y ,p2.y } ) );
-	float max_y = ceil ( std::max ( { p0.y, p1.y ,p2.y } ) );
+/**
+ * @brief
+ * appends a bin entry to every tile the bounding box of a triangle overlaps
+ * @param p0 , p1 , p2
+ * window coordinates of the triangle, within the guard band
+ * @param entry
+ * offset into Model::tri, or index into clipped_triangles with clipped_bit set
+*/
+void GLPbo::bin_bounds ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , GLuint entry )
+{
+	// inclusive of floor ( max ), the last pixel the box reaches into
+	GLint min_x = std::max ( static_cast< GLint >( std::floor ( std::min ( { p0.x , p1.x , p2.x } ) ) ) , 0 );
+	GLint max_x = std::min ( static_cast< GLint >( std::floor ( std::max ( { p0.x , p1.x , p2.x } ) ) ) , width - 1 );
+	GLint min_y = std::max ( static_cast< GLint >( std::floor ( std::min ( { p0.y , p1.y , p2.y } ) ) ) , 0 );
+	GLint max_y = std::min ( static_cast< GLint >( std::floor ( std::max ( { p0.y , p1.y , p2.y } ) ) ) , height - 1 );
+	if( min_x > max_x || min_y > max_y )
+	{
+		return;
+	}
 
-	bool top_left_e0 , top_left_e1 , top_left_e2 ;
-	float evaluation0 = EvaluateFragment ( line0 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e0 );
-	float evaluation1 = EvaluateFragment ( line1 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e1 );
-	float evaluation2 = EvaluateFragment ( line2 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e2 );
+	for( GLint ty = min_y / tile_size ; ty <= max_y / tile_size ; ++ty )
+	{
+		for( GLint tx = min_x / tile_size ; tx <= max_x / tile_size ; ++tx )
+		{
+			tile_bins[ ty * tile_cols + tx ].push_back ( entry );
+		}
+	}
+}
 
-	float double_area_triangle = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p2.x - p0.x ) * ( p1.y - p0.y );
+/**
+ * @brief
+ * Liang-Barsky clipping of a segment against a rectangle in window
+ * coordinates
+ * @param a , b
+ * end points of the segment, moved onto the rectangle if outside it
+ * @param x0 , y0 , x1 , y1
+ * the rectangle
+ * @return
+ * false if the segment misses the rectangle
+*/
+bool ClipSegment ( glm::vec3& a , glm::vec3& b , float x0 , float y0 , float x1 , float y1 )
+{
+	glm::vec3 const d = b - a;
+	float const p[ 4 ] = { -d.x , d.x , -d.y , d.y };
+	float const q[ 4 ] = { a.x - x0 , x1 - a.x , a.y - y0 , y1 - a.y };
+	float t0 = 0.0f , t1 = 1.0f;
+	for( int i = 0 ; i < 4 ; ++i )
+	{
+		if( p[ i ] == 0.0f )
+		{
+			if( q[ i ] < 0.0f )
+			{
+				return false;
+			}
+			continue;
+		}
+		float t = q[ i ] / p[ i ];
+		if( p[ i ] < 0.0f )
+		{
+			t0 = std::max ( t0 , t );
+		}
+		else
+		{
+			t1 = std::min ( t1 , t );
+		}
+	}
+	if( t0 > t1 )
+	{
+		return false;
+	}
+	b = a + t1 * d;
+	a = a + t0 * d;
+	return true;
+}
 
-	float sub_tri_e0 = evaluation0 / double_area_triangle;
-	float sub_tri_e1 = evaluation1 / double_area_triangle;
-	float sub_tri_e2 = evaluation2 / double_area_triangle;
+/**
+ * @brief
+ * the wireframe mode's counterpart of bin_triangles. Every edge with a
+ * visible triangle on either side becomes a line, drawn in the winding of
+ * that triangle, and is binned to the tiles its bounding box overlaps.
+ * Lines reaching past the guard band are clipped against it.
+ * @param model
+ * model whose visible_triangles are up to date
+*/
+void GLPbo::bin_edges ( Model const& model )
+{
+	GLPBO_TRACE_SCOPE ( "bin" );
 
-	float sub_tri_e0_inc_x = line0.x / double_area_triangle;
-	float sub_tri_e1_inc_x = line1.x / double_area_triangle;
-	float sub_tri_e2_inc_x = line2.x / double_area_triangle;
+	for( std::vector<GLuint>& bin : tile_bins )
+	{
+		bin.clear ();
+	}
+	lines.clear ();
+	triangle_visible.assign ( model.tri.size () / 3 , 0 );
+	for( GLuint i : visible_triangles )
+	{
+		triangle_visible[ i / 3 ] = 1;
+	}
 
-	float sub_tri_e0_inc_y = line0.y / double_area_triangle;
-	float sub_tri_e1_inc_y = line1.y / double_area_triangle;
-	float sub_tri_e2_inc_y = line2.y / double_area_triangle;
+	float const w = static_cast< float >( width );
+	float const h = static_cast< float >( height );
 
-	for( int y = ( int ) min_y ; y < ( int ) max_y ; ++y )
+	for( Edge const& edge : model.edges )
 	{
-		float Hevaluation0 = evaluation0;
-		float Hevaluation1 = evaluation1;
-		float Hevaluation2 = evaluation2;
+		GLuint corner = triangle_visible[ edge.face0 / 3 ] ? edge.face0 :
+			edge.face1 != no_face && triangle_visible[ edge.face1 / 3 ] ? edge.face1 : no_face;
+		if( corner == no_face )
+		{
+			continue;
+		}
+		glm::vec3 a = model.pd[ model.tri[ corner ] ];
+		glm::vec3 b = model.pd[ model.tri[ corner - corner % 3 + ( corner + 1 ) % 3 ] ];
 
-		float Hsub_tri_e0 = sub_tri_e0;
-		float Hsub_tri_e1 = sub_tri_e1;
-		float Hsub_tri_e2 = sub_tri_e2;
+		if( !( std::min ( a.x , b.x ) >= -guard_band && std::max ( a.x , b.x ) <= w + guard_band &&
+			std::min ( a.y , b.y ) >= -guard_band && std::max ( a.y , b.y ) <= h + guard_band ) &&
+			!ClipSegment ( a , b , -guard_band , -guard_band , w + guard_band , h + guard_band ) )
+		{
+			continue;
+		}
+		Line line{ ( GLint ) a.x , ( GLint ) a.y , ( GLint ) b.x , ( GLint ) b.y };
 
-		for( int x = ( int ) min_x ; x < ( int ) max_x ; ++x )
+		GLint min_x = std::max ( std::min ( line.x0 , line.x1 ) , 0 ) , max_x = std::min ( std::max ( line.x0 , line.x1 ) , width - 1 );
+		GLint min_y = std::max ( std::min ( line.y0 , line.y1 ) , 0 ) , max_y = std::min ( std::max ( line.y0 , line.y1 ) , height - 1 );
+		if( min_x > max_x || min_y > max_y )
+		{
+			continue;
+		}
+		GLuint entry = static_cast< GLuint >( lines.size () );
+		lines.push_back ( line );
+		for( GLint ty = min_y / tile_size ; ty <= max_y / tile_size ; ++ty )
 		{
-			if( PointInTriangleOptimized ( Hevaluation0 , Hevaluation1 , Hevaluation2 , { x + 0.5f , y + 0.5f, 0 } , { 0,0 } , top_left_e0 , top_left_e1 , top_left_e2 ) )
+			for( GLint tx = min_x / tile_size ; tx <= max_x / tile_size ; ++tx )
 			{
+				tile_bins[ ty * tile_cols + tx ].push_back ( entry );
+			}
+		}
+	}
+}
+
+/**
+ * @brief
+ * Sutherland-Hodgman clipping of a triangle against the guard band. The
+ * resulting polygon is split into a fan of ClippedTriangle which are binned
+ * like any other triangle. Each vertex carries its barycentrics in the
+ * original triangle, so shaders still see the attributes of the original.
+ * @param model
+ * model the triangle belongs to
+ * @param offset
+ * offset into Model::tri of the triangle
+*/
+void GLPbo::clip_triangle ( Model const& model , GLuint offset )
+{
+	++ThreadStatistics ().clipped;
+	struct ClipVertex
+	{
+		glm::vec3 p;
+		glm::vec3 bary;
+	};
+
+	glm::vec3 const& p0 = model.pd[ model.tri[ offset ] ];
+	glm::vec3 const& p1 = model.pd[ model.tri[ offset + 1 ] ];
+	glm::vec3 const& p2 = model.pd[ model.tri[ offset + 2 ] ];
+
+	// orientation in double, the snapped test could overflow this far out
+	double area = ( double ( p1.x ) - p0.x ) * ( double ( p2.y ) - p0.y ) - ( double ( p2.x ) - p0.x ) * ( double ( p1.y ) - p0.y );
+	if( !( area > 0 ) )
+	{
+		++ThreadStatistics ().culled;
+		return;
+	}
 
-				glm::vec2 color = Hsub_tri_e0 * texture0 + Hsub_tri_e1 * texture1 + Hsub_tri_e2 * texture2;
-				glm::vec3 tex_color = texture.GetColor ( color );
+	// a triangle has at most 3 + 4 vertices after clipping against 4 planes
+	ClipVertex poly[ 7 ] = { { p0 , { 1 , 0 , 0 } } , { p1 , { 0 , 1 , 0 } } , { p2 , { 0 , 0 , 1 } } };
+	int count = 3;
 
-				float z_value = Hsub_tri_e0 * p0.z + Hsub_tri_e1 * p1.z + Hsub_tri_e2 * p2.z;
-				glm::vec3 tri_point = Hsub_tri_e0 * model.pm[ index0 ] + Hsub_tri_e1 * model.pm[ index1 ] + Hsub_tri_e2 * model.pm[ index2 ];
-				glm::vec3 tri_normal = Hsub_tri_e0 * model.nml[ index0 ] + Hsub_tri_e1 * model.nml[ index1 ] + Hsub_tri_e2 * model.nml[ index2 ];
-				float light = Calculate_Light ( point_light , tri_point , tri_normal );
-				set_pixel ( x , y , z_value , { static_cast< GLubyte >( light * tex_color.x ) , static_cast< GLubyte > ( light * tex_color.y ) ,static_cast< GLubyte >( light * tex_color.z ) , 255 } );
+	// planes as axis , sign , limit : inside when sign * p[ axis ] <= limit
+	float const planes[ 4 ][ 3 ] =
+	{
+		{ 0 , -1 , guard_band } ,
+		{ 0 ,  1 , width + guard_band } ,
+		{ 1 , -1 , guard_band } ,
+		{ 1 ,  1 , height + guard_band }
+	};
+	for( auto const& plane : planes )
+	{
+		int axis = static_cast< int >( plane[ 0 ] );
+		ClipVertex out[ 7 ];
+		int out_count = 0;
+		for( int k = 0 ; k < count ; ++k )
+		{
+			ClipVertex const& a = poly[ k ];
+			ClipVertex const& b = poly[ ( k + 1 ) % count ];
+			bool a_in = plane[ 1 ] * a.p[ axis ] <= plane[ 2 ];
+			bool b_in = plane[ 1 ] * b.p[ axis ] <= plane[ 2 ];
+			if( a_in )
+			{
+				out[ out_count++ ] = a;
 			}
-			Hevaluation0 += line0.x;
-			Hevaluation1 += line1.x;
-			Hevaluation2 += line2.x;
+			if( a_in != b_in )
+			{
+				// always interpolate from the inside vertex so that an edge shared
+				// by two triangles is cut at exactly the same point by both
+				ClipVertex const& in = a_in ? a : b;
+				ClipVertex const& ex = a_in ? b : a;
+				float t = ( plane[ 1 ] * plane[ 2 ] - in.p[ axis ] ) / ( ex.p[ axis ] - in.p[ axis ] );
+				ClipVertex cut{ in.p + t * ( ex.p - in.p ) , in.bary + t * ( ex.bary - in.bary ) };
+				cut.p[ axis ] = plane[ 1 ] * plane[ 2 ];
+				out[ out_count++ ] = cut;
+			}
+		}
+		std::copy ( out , out + out_count , poly );
+		count = out_count;
+		if( count < 3 )
+		{
+			++ThreadStatistics ().culled;
+			return;
+		}
+	}
+
+	for( int k = 1 ; k + 1 < count ; ++k )
+	{
+		ClippedTriangle piece;
+		piece.p[ 0 ] = poly[ 0 ].p;
+		piece.p[ 1 ] = poly[ k ].p;
+		piece.p[ 2 ] = poly[ k + 1 ].p;
+		piece.to_parent = glm::mat3 ( poly[ 0 ].bary , poly[ k ].bary , poly[ k + 1 ].bary );
+		piece.parent = offset;
+
+		clipped_triangles.push_back ( piece );
+		bin_bounds ( piece.p[ 0 ] , piece.p[ 1 ] , piece.p[ 2 ] , static_cast< GLuint >( clipped_triangles.size () - 1 ) | clipped_bit );
+	}
+}
 
-			Hsub_tri_e0 += sub_tri_e0_inc_x;
-			Hsub_tri_e1 += sub_tri_e1_inc_x;
-			Hsub_tri_e2 += sub_tri_e2_inc_x;
+/**
+ * @brief
+ * assigns the lights to the screen tiles, each tile lists the lights whose
+ * sphere reaches into it. The projection is orthographic, so a light covers
+ * the tiles within its radius of the light's window position, at any depth.
+*/
+void GLPbo::assign_lights ()
+{
+	GLPBO_TRACE_SCOPE ( "lights" );
+	// window = scale * world + offset, as in viewport_transform
+	glm::vec2 const scale{ width / 2.0f , height / 2.0f };
+	glm::vec2 const offset{ width / 2.0f , height / 2.0f };
 
+	thread_pool.parallel_for ( static_cast< int >( tile_lights.size () ) , [ & ] ( int tile , int )
+	{
+		GLint x0 = ( tile % tile_cols ) * tile_size;
+		GLint y0 = ( tile / tile_cols ) * tile_size;
+		glm::vec2 lo = ( glm::vec2 ( x0 , y0 ) - offset ) / scale;
+		glm::vec2 hi = ( glm::vec2 ( std::min ( x0 + tile_size , width ) , std::min ( y0 + tile_size , height ) ) - offset ) / scale;
+
+		std::vector<GLuint>& lights = tile_lights[ tile ];
+		lights.clear ();
+		for( GLuint l = 0 ; l < point_lights.size () ; ++l )
+		{
+			PointLight const& point_light = point_lights[ l ];
+			if( point_light.radius > 0.0f )
+			{
+				glm::vec2 center{ point_light.position };
+				glm::vec2 nearest = glm::clamp ( center , lo , hi );
+				if( glm::dot ( nearest - center , nearest - center ) > point_light.radius * point_light.radius )
+				{
+					continue;
+				}
+			}
+			lights.push_back ( l );
 		}
-		evaluation0 += line0.y;
-		evaluation1 += line1.y;
-		evaluation2 += line2.y;
+	} );
+}
+
+/**
+ * @brief
+ * replaces the lights after the key light with count - 1 small coloured
+ * ones at random positions around the model. Their radius shrinks with the
+ * square root of the count, so about as many reach a tile whatever the
+ * count. The key light is dimmed while they are on, so that their colour
+ * does not saturate. The generator is seeded the same every time, so a
+ * count always gives the same lights.
+ * @param count
+ * number of lights including the key light
+*/
+void GLPbo::set_light_count ( size_t count )
+{
+	point_lights.resize ( 1 );
+	point_lights[ 0 ].intensity = glm::vec3 ( count > 1 ? 0.4f : 1.0f );
+	std::mt19937 generator ( 2021 );
+	std::uniform_real_distribution<float> position ( -1.0f , 1.0f );
+	std::uniform_real_distribution<float> channel ( 0.2f , 1.0f );
+	float const size = 1.0f / std::sqrt ( static_cast< float >( std::max ( count , size_t{ 1 } ) ) );
+	std::uniform_real_distribution<float> radius ( 2.0f * size , 4.0f * size );
+	for( size_t l = 1 ; l < count ; ++l )
+	{
+		PointLight point_light{};
+		point_light.intensity = glm::vec3 ( channel ( generator ) , channel ( generator ) , channel ( generator ) ) * 0.5f;
+		point_light.position = glm::vec3 ( position ( generator ) , position ( generator ) , position ( generator ) );
+		point_light.radius = radius ( generator );
+		point_lights.push_back ( point_light );
+	}
+}
+
+/**
+ * @brief
+ * rasterizes every triangle binned to a tile with the current render mode.
+ * All writes of the calling thread are clipped to the tile.
+ * @param tile
+ * index of the tile in tile_bins
+ * @param model
+ * model the binned triangles belong to
+*/
+void GLPbo::render_tile ( int tile , Model& model )
+{
+	GLPBO_TRACE_SCOPE ( "tile" );
+	GLint x0 = ( tile % tile_cols ) * tile_size;
+	GLint y0 = ( tile / tile_cols ) * tile_size;
+	scissor = { x0 , y0 , std::min ( x0 + tile_size , width ) , std::min ( y0 + tile_size , height ) };
+	current_tile = tile;
+
+	// the mode is resolved once per tile, each case is its own instantiation of
+	// the triangle pipeline
+	std::vector<GLuint> const& bin = tile_bins[ tile ];
+	if( !bin.empty () )
+	{
+		framebuffer.Touch ( tile );
+	}
+	switch( mode )
+	{
+		case Mode::wireframe_black:
+		{
+			GLPBO_TRACE_SCOPE ( "raster" );
+			for( GLuint i : bin )
+			{
+				Line const& line = lines[ i ];
+				render_linebresenham ( line.x0 , line.y0 , line.x1 , line.y1 , { 0, 0, 0 ,255 } );
+			}
+			break;
+		}
+		case Mode::shadow_mapping:
+			render_bin< ShadowMapShader > ( bin , model );
+			break;
+		case Mode::point_light:
+			render_bin< PointLightShader > ( bin , model );
+			break;
+		case Mode::faceted:
+			render_bin< FacetedShader > ( bin , model );
+			break;
+		case Mode::texture:
+			render_bin< TextureShader > ( bin , model );
+			break;
+		case Mode::texture_point_light:
+			render_bin< TexturePointLightShader > ( bin , model );
+			break;
+		case Mode::texture_faceted:
+			render_bin< TextureFacetedShader > ( bin , model );
+			break;
+		case Mode::visibility_buffer:
+			// first pass only keeps the nearest triangle of every pixel, the
+			// second then shades each covered pixel of the tile once
+			{
+				GLPBO_TRACE_SCOPE ( "raster" );
+				for( GLint y = scissor.y0 ; y < scissor.y1 ; ++y )
+				{
+					std::fill ( visibility_buffer.begin () + y * width + scissor.x0 , visibility_buffer.begin () + y * width + scissor.x1 , VisibilitySample{ no_triangle , 0.0f , 0.0f , 0.0f } );
+				}
+				for( GLuint i : bin )
+				{
+					if( i & clipped_bit )
+					{
+						ClippedTriangle const& piece = clipped_triangles[ i & ~clipped_bit ];
+						current_triangle = piece.parent;
+						rasterize ( piece.p[ 0 ] , piece.p[ 1 ] , piece.p[ 2 ] , VisibilityShader{ piece.parent } , &piece.to_parent );
+						continue;
+					}
+					current_triangle = i;
+					rasterize ( model.pd[ model.tri[ i ] ] , model.pd[ model.tri[ i + 1 ] ] , model.pd[ model.tri[ i + 2 ] ] , VisibilityShader{ i } );
+				}
+			}
+			{
+				GLPBO_TRACE_SCOPE ( "resolve" );
+				resolve_tile< TexturePointLightShader > ( model );
+			}
+			break;
+		default:
+			break;
+	}
+	store_tile ( tile );
+}
+
+/**
+ * @brief
+ * the triangle pipeline. Sets up the fixed-point edge functions, walks the
+ * bounding box clipped to the calling thread's tile in blocks and hands every
+ * covered fragment to the shader. The triangle must lie within the guard
+ * band, see clip_triangle. Depth-tested shaders only run for fragments
+ * that pass the depth test, which is done and written before shading.
+ * @param p0
+ * 1st vertices of the triangle
+ * @param p1
+ * 2nd vertices of the triangle
+ * @param p2
+ * 3rd vertices of the triangle
+ * @param shader
+ * fragment shader, see ShadowMapShader and the others above
+ * @param to_parent
+ * for a piece of a clipped triangle, maps its barycentrics to those of the
+ * original triangle the shader expects. nullptr otherwise
+ * @return
+ * if triangle was successfully rendered which is not backface-culled.
+*/
+template < typename Shader >
+bool GLPbo::rasterize ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Shader const& shader , glm::mat3 const* to_parent )
+{
+	// back-facing or degenerate once snapped to the sub-pixel grid
+	Edges edges;
+	if( !SetupEdges ( p0 , p1 , p2 , edges ) )
+	{
+		return false;
+	}
+
+	// bounding box clipped against the tile owned by the calling thread
+	GLint min_x = std::max ( edges.bounds.x0 , scissor.x0 );
+	GLint max_x = std::min ( edges.bounds.x1 , scissor.x1 );
+	GLint min_y = std::max ( edges.bounds.y0 , scissor.y0 );
+	GLint max_y = std::min ( edges.bounds.y1 , scissor.y1 );
+
+	float double_area_triangle = static_cast< float >( edges.area );
+	glm::vec3 ddx , ddy;
+	BarycentricDerivatives ( p0 , p1 , p2 , ddx , ddy );
+	if( to_parent )
+	{
+		ddx = *to_parent * ddx;
+		ddy = *to_parent * ddy;
+	}
+	if( Shader::color_write && framebuffer.samples > 1 )
+	{
+		return rasterize_multisample ( p0 , p1 , p2 , edges , shader , to_parent , ddx , ddy );
+	}
+	unsigned int tested = 0;
+	unsigned int fragments = 0;
+	unsigned int occluded = 0;
+
+	// the bounding box is walked in block_size x block_size blocks. Blocks outside
+	// an edge are skipped, blocks inside all three edges skip the per-fragment
+	// test, only blocks crossed by an edge test each fragment
+	for( int block_y = min_y ; block_y < max_y ; block_y += block_size )
+	{
+		for( int block_x = min_x ; block_x < max_x ; block_x += block_size )
+		{
+			std::int64_t row[ 3 ] = { EvaluateFragment ( edges , 0 , block_x , block_y ) , EvaluateFragment ( edges , 1 , block_x , block_y ) , EvaluateFragment ( edges , 2 , block_x , block_y ) };
+			BlockCoverage coverage = ClassifyBlock ( edges , row );
+			if( coverage == BlockCoverage::outside )
+			{
+				continue;
+			}
+
+			int end_x = std::min ( block_x + block_size , max_x );
+			int end_y = std::min ( block_y + block_size , max_y );
+			tested += ( end_x - block_x ) * ( end_y - block_y );
+			for( int y = block_y ; y < end_y ; ++y )
+			{
+				std::int64_t span[ 3 ] = { row[ 0 ] , row[ 1 ] , row[ 2 ] };
+				for( int span_x = block_x ; span_x < end_x ; span_x += coverage_lanes )
+				{
+					alignas( 32 ) std::int64_t Hevaluation0[ coverage_lanes ] , Hevaluation1[ coverage_lanes ] , Hevaluation2[ coverage_lanes ];
+					unsigned int mask = CoverageMask ( edges , span , Hevaluation0 , Hevaluation1 , Hevaluation2 , coverage == BlockCoverage::inside ) & SpanMask ( end_x - span_x );
+
+					for( ; mask ; mask &= mask - 1 )
+					{
+						int lane = LowestLane ( mask );
+						Varyings v;
+						v.x = span_x + lane;
+						v.y = y;
+						v.b0 = static_cast< float >( Hevaluation0[ lane ] ) / double_area_triangle;
+						v.b1 = static_cast< float >( Hevaluation1[ lane ] ) / double_area_triangle;
+						v.b2 = static_cast< float >( Hevaluation2[ lane ] ) / double_area_triangle;
+						v.z = v.interpolate ( p0.z , p1.z , p2.z );
+						v.ddx = ddx;
+						v.ddy = ddy;
+						if( to_parent )
+						{
+							glm::vec3 b = *to_parent * glm::vec3 ( v.b0 , v.b1 , v.b2 );
+							v.b0 = b.x;
+							v.b1 = b.y;
+							v.b2 = b.z;
+						}
+						++fragments;
+
+						// early depth test, the shader is skipped for hidden fragments
+						if( Shader::depth_test )
+						{
+							float& depth = framebuffer.depth[ framebuffer.Index ( v.x , v.y ) ];
+							if( v.z <= depth )
+							{
+								++occluded;
+								continue;
+							}
+							depth = v.z;
+						}
+						if( Shader::color_write )
+						{
+							set_pixel ( v.x , v.y , shader ( v ) );
+						}
+						else
+						{
+							shader ( v );
+						}
+					}
+				}
+				row[ 0 ] += edges.step_y[ 0 ];
+				row[ 1 ] += edges.step_y[ 1 ];
+				row[ 2 ] += edges.step_y[ 2 ];
+			}
+		}
+	}
+
+	CountFragments< Shader > ( tested , fragments , occluded );
+	return true;
+}
+
+/**
+ * @brief
+ * rasterize for a multisampled frame. A pixel is touched when any of its
+ * framebuffer.samples samples is inside the triangle; the covered samples are
+ * depth tested one by one, and the shader runs once for the pixel if any
+ * of them passed. It is evaluated at the pixel center, or at the first
+ * covered sample when the center lies outside, so that attributes are not
+ * extrapolated past the triangle.
+ * @param p0 , p1 , p2
+ * window coordinates of the triangle
+ * @param edges
+ * edge functions set up by rasterize
+ * @param shader
+ * fragment shader
+ * @param to_parent
+ * see rasterize
+ * @param ddx , ddy
+ * derivatives of the barycentric coordinates the shader sees
+ * @return
+ * true, the triangle was set up by rasterize
+*/
+template < typename Shader >
+bool GLPbo::rasterize_multisample ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Edges const& edges , Shader const& shader , glm::mat3 const* to_parent , glm::vec3 const& ddx , glm::vec3 const& ddy )
+{
+	int const samples = framebuffer.samples;
+	int const ( *pattern )[ 2 ] = samples == 8 ? sample_pattern_8 : sample_pattern_4;
+	unsigned int const full = ( 1u << samples ) - 1;
+
+	float double_area_triangle = static_cast< float >( edges.area );
+
+	// change of every edge function from the pixel center to each sample,
+	// exact since the samples lie on the sub-pixel grid, and of the depth
+	std::int64_t offset[ 3 ][ max_samples ];
+	std::int64_t offset_min[ 3 ] , offset_max[ 3 ];
+	float z_offset[ max_samples ];
+	for( int i = 0 ; i < 3 ; ++i )
+	{
+		for( int s = 0 ; s < samples ; ++s )
+		{
+			offset[ i ][ s ] = ( edges.step_x[ i ] * pattern[ s ][ 0 ] + edges.step_y[ i ] * pattern[ s ][ 1 ] ) / subpixel_one;
+		}
+		offset_min[ i ] = *std::min_element ( offset[ i ] , offset[ i ] + samples );
+		offset_max[ i ] = *std::max_element ( offset[ i ] , offset[ i ] + samples );
+	}
+	for( int s = 0 ; s < samples ; ++s )
+	{
+		z_offset[ s ] = ( static_cast< float >( offset[ 0 ][ s ] ) * p0.z + static_cast< float >( offset[ 1 ][ s ] ) * p1.z + static_cast< float >( offset[ 2 ][ s ] ) * p2.z ) / double_area_triangle;
+	}
+
+	// samples reach up to half a pixel past the centers the bounds were made for
+	GLint min_x = std::max ( edges.bounds.x0 - 1 , scissor.x0 );
+	GLint max_x = std::min ( edges.bounds.x1 + 1 , scissor.x1 );
+	GLint min_y = std::max ( edges.bounds.y0 - 1 , scissor.y0 );
+	GLint max_y = std::min ( edges.bounds.y1 + 1 , scissor.y1 );
+
+	unsigned int tested = 0;
+	unsigned int fragments = 0;
+	unsigned int occluded = 0;
+
+	for( int block_y = min_y ; block_y < max_y ; block_y += block_size )
+	{
+		for( int block_x = min_x ; block_x < max_x ; block_x += block_size )
+		{
+			// ClassifyBlock widened by the sample offsets
+			std::int64_t row[ 3 ] = { EvaluateFragment ( edges , 0 , block_x , block_y ) , EvaluateFragment ( edges , 1 , block_x , block_y ) , EvaluateFragment ( edges , 2 , block_x , block_y ) };
+			bool outside = false;
+			bool inside = true;
+			for( int i = 0 ; i < 3 ; ++i )
+			{
+				outside = outside || row[ i ] + edges.block_max[ i ] + offset_max[ i ] - edges.bias[ i ] < 0;
+				inside = inside && row[ i ] + edges.block_min[ i ] + offset_min[ i ] - edges.bias[ i ] >= 0;
+			}
+			if( outside )
+			{
+				continue;
+			}
+
+			int end_x = std::min ( block_x + block_size , max_x );
+			int end_y = std::min ( block_y + block_size , max_y );
+			tested += ( end_x - block_x ) * ( end_y - block_y );
+			for( int y = block_y ; y < end_y ; ++y )
+			{
+				std::int64_t e[ 3 ] = { row[ 0 ] , row[ 1 ] , row[ 2 ] };
+				for( int x = block_x ; x < end_x ; ++x , e[ 0 ] += edges.step_x[ 0 ] , e[ 1 ] += edges.step_x[ 1 ] , e[ 2 ] += edges.step_x[ 2 ] )
+				{
+					// the samples only need testing one by one where an edge
+					// passes between them
+					unsigned int mask = full;
+					if( !inside && ( e[ 0 ] + offset_min[ 0 ] - edges.bias[ 0 ] < 0 || e[ 1 ] + offset_min[ 1 ] - edges.bias[ 1 ] < 0 || e[ 2 ] + offset_min[ 2 ] - edges.bias[ 2 ] < 0 ) )
+					{
+						if( e[ 0 ] + offset_max[ 0 ] - edges.bias[ 0 ] < 0 || e[ 1 ] + offset_max[ 1 ] - edges.bias[ 1 ] < 0 || e[ 2 ] + offset_max[ 2 ] - edges.bias[ 2 ] < 0 )
+						{
+							continue;
+						}
+						mask = 0;
+						for( int s = 0 ; s < samples ; ++s )
+						{
+							if( e[ 0 ] + offset[ 0 ][ s ] - edges.bias[ 0 ] >= 0 && e[ 1 ] + offset[ 1 ][ s ] - edges.bias[ 1 ] >= 0 && e[ 2 ] + offset[ 2 ][ s ] - edges.bias[ 2 ] >= 0 )
+							{
+								mask |= 1u << s;
+							}
+						}
+						if( !mask )
+						{
+							continue;
+						}
+					}
+
+					Varyings v;
+					v.x = x;
+					v.y = y;
+					v.b0 = static_cast< float >( e[ 0 ] ) / double_area_triangle;
+					v.b1 = static_cast< float >( e[ 1 ] ) / double_area_triangle;
+					v.b2 = static_cast< float >( e[ 2 ] ) / double_area_triangle;
+					v.z = v.interpolate ( p0.z , p1.z , p2.z );
+					v.ddx = ddx;
+					v.ddy = ddy;
+					++fragments;
+
+					size_t const pixel = framebuffer.Index ( x , y );
+					float* depth = &framebuffer.depth[ pixel ];
+					if( Shader::depth_test )
+					{
+						unsigned int passed = 0;
+						for( int s = 0 ; s < samples ; ++s )
+						{
+							float z = v.z + z_offset[ s ];
+							if( ( mask >> s & 1 ) && z > depth[ s ] )
+							{
+								depth[ s ] = z;
+								passed |= 1u << s;
+							}
+						}
+						if( !passed )
+						{
+							++occluded;
+							continue;
+						}
+						mask = passed;
+					}
+
+					if( e[ 0 ] - edges.bias[ 0 ] < 0 || e[ 1 ] - edges.bias[ 1 ] < 0 || e[ 2 ] - edges.bias[ 2 ] < 0 )
+					{
+						int s = LowestLane ( mask );
+						v.b0 = static_cast< float >( e[ 0 ] + offset[ 0 ][ s ] ) / double_area_triangle;
+						v.b1 = static_cast< float >( e[ 1 ] + offset[ 1 ][ s ] ) / double_area_triangle;
+						v.b2 = static_cast< float >( e[ 2 ] + offset[ 2 ][ s ] ) / double_area_triangle;
+						v.z += z_offset[ s ];
+					}
+					if( to_parent )
+					{
+						glm::vec3 parent = *to_parent * glm::vec3 ( v.b0 , v.b1 , v.b2 );
+						v.b0 = parent.x;
+						v.b1 = parent.y;
+						v.b2 = parent.z;
+					}
+					Color color = shader ( v );
+					Color* sample = &framebuffer.color[ pixel ];
+					for( ; mask ; mask &= mask - 1 )
+					{
+						sample[ LowestLane ( mask ) ] = color;
+					}
+				}
+				row[ 0 ] += edges.step_y[ 0 ];
+				row[ 1 ] += edges.step_y[ 1 ];
+				row[ 2 ] += edges.step_y[ 2 ];
+			}
+		}
+	}
+
+	CountFragments< Shader > ( tested , fragments , occluded );
+	return true;
+}
+
+/**
+ * @brief
+ * allocates the framebuffer
+ * @param tiles
+ * number of tiles, tile_cols * tile_rows
+ * @param sample_cnt
+ * samples per pixel
+*/
+void GLPbo::Framebuffer::Resize ( int tiles , int sample_cnt )
+{
+	samples = sample_cnt;
+	size_t size = static_cast< size_t >( tiles ) * tile_size * tile_size * samples;
+	color.assign ( size , Color{} );
+	depth.assign ( size , 0.0f );
+	cleared.assign ( tiles , 1 );
+}
+
+/**
+ * @brief
+ * fast clear, flags every tile as cleared without writing any pixel
+*/
+void GLPbo::Framebuffer::Clear ()
+{
+	std::fill ( cleared.begin () , cleared.end () , std::uint8_t ( 1 ) );
+}
+
+/**
+ * @brief
+ * brings a cleared tile into use before it is rendered to, filling it with
+ * the clear color and the farthest depth
+ * @param tile
+ * index of the tile
+*/
+void GLPbo::Framebuffer::Touch ( int tile )
+{
+	if( !cleared[ tile ] )
+	{
+		return;
+	}
+	GLPBO_TRACE_SCOPE ( "clear" );
+	size_t size = static_cast< size_t >( tile_size ) * tile_size * samples;
+	std::fill_n ( color.begin () + tile * size , size , clear_clr );
+	std::fill_n ( depth.begin () + tile * size , size , 0.0f );
+	cleared[ tile ] = 0;
+}
+
+/**
+ * @brief
+ * writes a tile of the framebuffer to its rows of the PBO. A tile nothing
+ * was rendered to is filled with the clear color, a single-sampled one is
+ * copied and a multisampled one averages the samples of every pixel,
+ * copying pixels inside a single triangle whose samples all agree.
+ * @param tile
+ * index of the tile
+*/
+void GLPbo::store_tile ( int tile )
+{
+	GLPBO_TRACE_SCOPE ( "store" );
+	GLint x0 = ( tile % tile_cols ) * tile_size;
+	GLint y0 = ( tile / tile_cols ) * tile_size;
+	GLint x1 = std::min ( x0 + tile_size , width );
+	GLint y1 = std::min ( y0 + tile_size , height );
+	int const samples = framebuffer.samples;
+
+	for( GLint y = y0 ; y < y1 ; ++y )
+	{
+		Color* row = ptr_to_pbo + static_cast< size_t >( y ) * width;
+		if( framebuffer.cleared[ tile ] )
+		{
+			fill_colors ( row + x0 , x1 - x0 , clear_clr );
+			continue;
+		}
+		Color const* sample = &framebuffer.color[ framebuffer.Index ( x0 , y ) ];
+		if( samples == 1 )
+		{
+			copy_colors ( row + x0 , sample , x1 - x0 );
+			continue;
+		}
+		// resolved into a row of the tile first, so that the PBO is still
+		// only written by copy_colors
+		Color resolved[ tile_size ];
+		for( GLint x = x0 ; x < x1 ; ++x , sample += samples )
+		{
+			GLuint differ = 0;
+			for( int s = 1 ; s < samples ; ++s )
+			{
+				differ |= sample[ s ].raw ^ sample[ 0 ].raw;
+			}
+			if( !differ )
+			{
+				resolved[ x - x0 ] = sample[ 0 ];
+				continue;
+			}
+			unsigned int sum[ 4 ] = { 0 , 0 , 0 , 0 };
+			for( int s = 0 ; s < samples ; ++s )
+			{
+				for( int channel = 0 ; channel < 4 ; ++channel )
+				{
+					sum[ channel ] += sample[ s ].val[ channel ];
+				}
+			}
+			for( int channel = 0 ; channel < 4 ; ++channel )
+			{
+				resolved[ x - x0 ].val[ channel ] = static_cast< GLubyte >( ( sum[ channel ] + samples / 2 ) / samples );
+			}
+		}
+		copy_colors ( row + x0 , resolved , x1 - x0 );
+	}
+}
+
+#if defined( GLPBO_AVX2 ) || defined( GLPBO_SSE2 )
+/**
+ * @brief
+ * fill with 16 byte streaming stores, which write whole lines around the
+ * cache. Single stores cover the unaligned head and the tail.
+ * @param dst
+ * first Color to write
+ * @param count
+ * number of Colors
+ * @param clr
+ * the color
+*/
+void FillStreamSSE2 ( GLPbo::Color* dst , size_t count , GLPbo::Color clr )
+{
+	for( ; count && reinterpret_cast< std::uintptr_t >( dst ) % 16 ; --count )
+	{
+		*dst++ = clr;
+	}
+	__m128i const value = _mm_set1_epi32 ( static_cast< int >( clr.raw ) );
+	for( ; count >= 4 ; count -= 4 , dst += 4 )
+	{
+		_mm_stream_si128 ( reinterpret_cast< __m128i* >( dst ) , value );
+	}
+	_mm_sfence ();
+	std::fill_n ( dst , count , clr );
+}
+
+/**
+ * @brief
+ * copy with 16 byte streaming stores to dst, src may be unaligned
+ * @param dst
+ * first Color to write
+ * @param src
+ * first Color to read
+ * @param count
+ * number of Colors
+*/
+void CopyStreamSSE2 ( GLPbo::Color* dst , GLPbo::Color const* src , size_t count )
+{
+	for( ; count && reinterpret_cast< std::uintptr_t >( dst ) % 16 ; --count )
+	{
+		*dst++ = *src++;
+	}
+	for( ; count >= 4 ; count -= 4 , dst += 4 , src += 4 )
+	{
+		_mm_stream_si128 ( reinterpret_cast< __m128i* >( dst ) , _mm_loadu_si128 ( reinterpret_cast< __m128i const* >( src ) ) );
+	}
+	_mm_sfence ();
+	std::copy ( src , src + count , dst );
+}
+#endif
+
+#if defined( GLPBO_AVX2 )
+/**
+ * @brief
+ * FillStreamSSE2 with 32 byte stores
+*/
+void FillStreamAVX ( GLPbo::Color* dst , size_t count , GLPbo::Color clr )
+{
+	for( ; count && reinterpret_cast< std::uintptr_t >( dst ) % 32 ; --count )
+	{
+		*dst++ = clr;
+	}
+	__m256i const value = _mm256_set1_epi32 ( static_cast< int >( clr.raw ) );
+	for( ; count >= 8 ; count -= 8 , dst += 8 )
+	{
+		_mm256_stream_si256 ( reinterpret_cast< __m256i* >( dst ) , value );
+	}
+	_mm_sfence ();
+	std::fill_n ( dst , count , clr );
+}
+
+/**
+ * @brief
+ * CopyStreamSSE2 with 32 byte stores
+*/
+void CopyStreamAVX ( GLPbo::Color* dst , GLPbo::Color const* src , size_t count )
+{
+	for( ; count && reinterpret_cast< std::uintptr_t >( dst ) % 32 ; --count )
+	{
+		*dst++ = *src++;
+	}
+	for( ; count >= 8 ; count -= 8 , dst += 8 , src += 8 )
+	{
+		_mm256_stream_si256 ( reinterpret_cast< __m256i* >( dst ) , _mm256_loadu_si256 ( reinterpret_cast< __m256i const* >( src ) ) );
+	}
+	_mm_sfence ();
+	std::copy ( src , src + count , dst );
+}
+#endif
+
+/**
+ * @brief
+ * fills count Colors with the kernel select_kernels picked
+ * @param dst
+ * first Color to write
+ * @param count
+ * number of Colors
+ * @param clr
+ * the color
+*/
+void GLPbo::fill_colors ( Color* dst , size_t count , Color clr )
+{
+	switch( fill_kernel )
+	{
+#if defined( GLPBO_AVX2 )
+		case Kernel::avx_stream:
+			FillStreamAVX ( dst , count , clr );
+			break;
+#endif
+#if defined( GLPBO_AVX2 ) || defined( GLPBO_SSE2 )
+		case Kernel::sse2_stream:
+			FillStreamSSE2 ( dst , count , clr );
+			break;
+#endif
+		default:
+			std::fill_n ( dst , count , clr );
+			break;
+	}
+}
+
+/**
+ * @brief
+ * copies count Colors with the kernel select_kernels picked
+ * @param dst
+ * first Color to write
+ * @param src
+ * first Color to read, must not overlap dst
+ * @param count
+ * number of Colors
+*/
+void GLPbo::copy_colors ( Color* dst , Color const* src , size_t count )
+{
+	switch( copy_kernel )
+	{
+#if defined( GLPBO_AVX2 )
+		case Kernel::avx_stream:
+			CopyStreamAVX ( dst , src , count );
+			break;
+#endif
+#if defined( GLPBO_AVX2 ) || defined( GLPBO_SSE2 )
+		case Kernel::sse2_stream:
+			CopyStreamSSE2 ( dst , src , count );
+			break;
+#endif
+		default:
+			std::copy ( src , src + count , dst );
+			break;
+	}
+}
+
+/**
+ * @brief
+ * times every fill and copy kernel built for this machine on the mapped
+ * PBO, prints their bandwidth and keeps the fastest of each. The kernels
+ * are timed the way store_tile calls them : one call , and one fence , per
+ * row of a tile , with the tiles spread over the active threads of the pool.
+*/
+void GLPbo::select_kernels ()
+{
+	static char const* const names[] = { "scalar" , "sse2 stream" , "avx stream" };
+	int const repeats = 8;
+	int const tile_cnt = tile_cols * tile_rows;
+	// in the tile order of a single-sampled framebuffer
+	std::vector<Color> source ( static_cast< size_t >( tile_cnt ) * tile_size * tile_size , clear_clr );
+
+#if defined( GLPBO_HEADLESS )
+	Color* pbo = ptr_to_pbo;
+#else
+	glBindBuffer ( GL_PIXEL_UNPACK_BUFFER , pboid );
+	Color* pbo = reinterpret_cast< Color* >( glMapNamedBuffer ( pboid , GL_WRITE_ONLY ) );
+#endif
+
+	// best of repeats runs over the whole window, in GB/s
+	auto bandwidth = [ & ] ( std::function<void ()> const& kernel )
+	{
+		double best = 0.0;
+		for( int repeat = 0 ; repeat < repeats ; ++repeat )
+		{
+			auto start = std::chrono::steady_clock::now ();
+			kernel ();
+			double seconds = std::chrono::duration<double> ( std::chrono::steady_clock::now () - start ).count ();
+			best = std::max ( best , seconds > 0.0 ? byte_cnt / seconds * 1e-9 : 0.0 );
+		}
+		return best;
+	};
+
+	// the rows store_tile writes, filled when copy is false
+	auto store = [ & ] ( bool copy )
+	{
+		thread_pool.parallel_for ( tile_cnt , [ & ] ( int tile , int )
+		{
+			GLint x0 = ( tile % tile_cols ) * tile_size;
+			GLint y0 = ( tile / tile_cols ) * tile_size;
+			GLint x1 = std::min ( x0 + tile_size , width );
+			GLint y1 = std::min ( y0 + tile_size , height );
+			Color const* sample = source.data () + static_cast< size_t >( tile ) * tile_size * tile_size;
+			for( GLint y = y0 ; y < y1 ; ++y , sample += tile_size )
+			{
+				Color* row = pbo + static_cast< size_t >( y ) * width + x0;
+				if( copy )
+				{
+					copy_colors ( row , sample , x1 - x0 );
+				}
+				else
+				{
+					fill_colors ( row , x1 - x0 , clear_clr );
+				}
+			}
+		} );
+	};
+
+	double best_fill = 0.0 , best_copy = 0.0;
+	Kernel fastest_fill = Kernel::scalar , fastest_copy = Kernel::scalar;
+	for( int k = 0 ; k < kernel_cnt ; ++k )
+	{
+		fill_kernel = copy_kernel = static_cast< Kernel >( k );
+		double fill = bandwidth ( [ & ] { store ( false ); } );
+		double copy = bandwidth ( [ & ] { store ( true ); } );
+		std::cout << "PBO " << std::left << std::setw ( 12 ) << names[ k ] << std::right << std::fixed << std::setprecision ( 2 )
+			<< " : fill " << fill << " GB/s , copy " << copy << " GB/s" << std::endl;
+		if( fill > best_fill )
+		{
+			best_fill = fill;
+			fastest_fill = fill_kernel;
+		}
+		if( copy > best_copy )
+		{
+			best_copy = copy;
+			fastest_copy = copy_kernel;
+		}
+	}
+	fill_kernel = fastest_fill;
+	copy_kernel = fastest_copy;
+	std::cout << "PBO kernels : fill " << names[ static_cast< int >( fill_kernel ) ] << " , copy " << names[ static_cast< int >( copy_kernel ) ]
+		<< " , timed on " << thread_pool.active () << " threads" << std::endl;
+
+#if !defined( GLPBO_HEADLESS )
+	glUnmapNamedBuffer ( pboid );
+	glBindBuffer ( GL_PIXEL_UNPACK_BUFFER , 0 );
+#endif
+}
+
+/**
+ * @brief
+ * runs the triangle pipeline over the triangles of one tile bin
+ * @param bin
+ * offsets into model.tri of the binned triangles
+ * @param model
+ * model the binned triangles belong to
+*/
+template < typename Shader >
+void GLPbo::render_bin ( std::vector<GLuint> const& bin , Model const& model )
+{
+	GLPBO_TRACE_SCOPE ( "raster" );
+	for( GLuint i : bin )
+	{
+		if( i & clipped_bit )
+		{
+			ClippedTriangle const& piece = clipped_triangles[ i & ~clipped_bit ];
+			current_triangle = piece.parent;
+			GLuint index0 = model.tri[ piece.parent ];
+			GLuint index1 = model.tri[ piece.parent + 1 ];
+			GLuint index2 = model.tri[ piece.parent + 2 ];
+			rasterize ( piece.p[ 0 ] , piece.p[ 1 ] , piece.p[ 2 ] , Shader ( model , index0 , index1 , index2 ) , &piece.to_parent );
+			continue;
+		}
+
+		current_triangle = i;
+		GLuint index0 = model.tri[ i ];
+		GLuint index1 = model.tri[ i + 1 ];
+		GLuint index2 = model.tri[ i + 2 ];
+		rasterize ( model.pd[ index0 ] , model.pd[ index1 ] , model.pd[ index2 ] , Shader ( model , index0 , index1 , index2 ) );
+	}
+}
+
+/**
+ * @brief
+ * shades the pixels of the calling thread's tile from the visibility buffer.
+ * Runs once per covered pixel, no matter how many triangles overlapped it.
+ * A row is shaded in runs of pixels of the same triangle, see ShadeRun.
+ * @param model
+ * model the triangle offsets in visibility_buffer refer to
+*/
+template < typename Shader >
+void GLPbo::resolve_tile ( Model const& model )
+{
+	// neighbouring pixels mostly share a triangle, so are its derivatives
+	GLuint last_triangle = no_triangle;
+	glm::vec3 ddx , ddy;
+	Varyings run[ tile_size ];
+	Color colors[ tile_size ];
+	unsigned int shaded = 0;
+	for( GLint y = scissor.y0 ; y < scissor.y1 ; ++y )
+	{
+		VisibilitySample const* row = &visibility_buffer[ y * width ];
+		for( GLint x = scissor.x0 ; x < scissor.x1 ; )
+		{
+			GLuint triangle = row[ x ].triangle;
+			if( triangle == no_triangle )
+			{
+				++x;
+				continue;
+			}
+
+			GLuint index0 = model.tri[ triangle ];
+			GLuint index1 = model.tri[ triangle + 1 ];
+			GLuint index2 = model.tri[ triangle + 2 ];
+			if( triangle != last_triangle )
+			{
+				BarycentricDerivatives ( model.pd[ index0 ] , model.pd[ index1 ] , model.pd[ index2 ] , ddx , ddy );
+				last_triangle = triangle;
+			}
+			int count = 0;
+			for( ; x < scissor.x1 && row[ x ].triangle == triangle ; ++x , ++count )
+			{
+				run[ count ] = { x , y , row[ x ].b0 , row[ x ].b1 , row[ x ].b2 , framebuffer.depth[ framebuffer.Index ( x , y ) ] , ddx , ddy };
+			}
+			ShadeRun ( Shader ( model , index0 , index1 , index2 ) , run , count , colors , std::integral_constant< bool , ( Shader::texture_samples > 0 ) >{} );
+			for( int k = 0 ; k < count ; ++k )
+			{
+				set_pixel ( run[ k ].x , y , colors[ k ] );
+			}
+			shaded += count;
+		}
+	}
+	PipelineStatistics& statistics = ThreadStatistics ();
+	statistics.fragments += shaded;
+	statistics.texture_samples += static_cast< std::uint64_t >( shaded ) * Shader::texture_samples;
+}
+
+/**
+ * @brief
+ * derivatives of the barycentric coordinates of a triangle in window
+ * space. With an affine projection they are the same for every fragment,
+ * so one evaluation per triangle stands in for the differences across a
+ * 2x2 quad.
+ * @param p0 , p1 , p2
+ * window coordinates of the vertices
+ * @param ddx
+ * receives the change of b0 , b1 , b2 per pixel in x
+ * @param ddy
+ * receives the change of b0 , b1 , b2 per pixel in y
+*/
+void GLPbo::BarycentricDerivatives ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , glm::vec3& ddx , glm::vec3& ddy )
+{
+	float area = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p2.x - p0.x ) * ( p1.y - p0.y );
+	if( area == 0.0f )
+	{
+		ddx = ddy = glm::vec3 ( 0.0f );
+		return;
+	}
+	ddx = glm::vec3 ( p1.y - p2.y , p2.y - p0.y , p0.y - p1.y ) / area;
+	ddy = glm::vec3 ( p2.x - p1.x , p0.x - p2.x , p1.x - p0.x ) / area;
+}
+
+/**
+ * @brief
+ * snaps a window coordinate to the sub-pixel grid
+ * @param v
+ * window coordinate in pixels
+ * @return
+ * v in fixed point with subpixel_bits fractional bits, rounded to nearest
+*/
+std::int64_t GLPbo::SnapToSubpixel ( float v )
+{
+	return static_cast< std::int64_t >( std::floor ( static_cast< double >( v ) * subpixel_one + 0.5 ) );
+}
+
+/**
+ * @brief
+ * triangle setup for the integer rasterizer. Snaps the vertices, builds the
+ * three edge functions and folds the top-left rule into a bias so that a
+ * fragment is inside an edge exactly when ( E - bias ) is not negative.
+ * @param p0 , p1 , p2
+ * window coordinates of the triangle
+ * @param edges
+ * user supplied Edges filled with the setup
+ * @return
+ * false if the snapped triangle is back-facing or has no area
+*/
+bool GLPbo::SetupEdges ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Edges& edges )
+{
+	std::int64_t const X[ 3 ] = { SnapToSubpixel ( p0.x ) , SnapToSubpixel ( p1.x ) , SnapToSubpixel ( p2.x ) };
+	std::int64_t const Y[ 3 ] = { SnapToSubpixel ( p0.y ) , SnapToSubpixel ( p1.y ) , SnapToSubpixel ( p2.y ) };
+
+	edges.area = ( X[ 1 ] - X[ 0 ] ) * ( Y[ 2 ] - Y[ 0 ] ) - ( X[ 2 ] - X[ 0 ] ) * ( Y[ 1 ] - Y[ 0 ] );
+	if( edges.area <= 0 )
+	{
+		return false;
+	}
+
+	std::int64_t const half = subpixel_one / 2;
+	for( int i = 0 ; i < 3 ; ++i )
+	{
+		int a = ( i + 1 ) % 3;
+		int b = ( i + 2 ) % 3;
+		std::int64_t A = Y[ a ] - Y[ b ];
+		std::int64_t B = X[ b ] - X[ a ];
+		std::int64_t C = X[ a ] * Y[ b ] - X[ b ] * Y[ a ];
+
+		edges.step_x[ i ] = A * subpixel_one;
+		edges.step_y[ i ] = B * subpixel_one;
+		edges.origin[ i ] = A * half + B * half + C;
+		// left edge or horizontal top edge
+		edges.bias[ i ] = ( A != 0 ? A > 0 : B < 0 ) ? 0 : 1;
+		for( int lane = 0 ; lane < coverage_lanes ; ++lane )
+		{
+			edges.lane_offset[ i ][ lane ] = lane * edges.step_x[ i ];
+		}
+
+		// the edge function is linear, so over a block it is extreme at the corners
+		std::int64_t across_x = edges.step_x[ i ] * ( block_size - 1 );
+		std::int64_t across_y = edges.step_y[ i ] * ( block_size - 1 );
+		edges.block_min[ i ] = std::min ( across_x , std::int64_t ( 0 ) ) + std::min ( across_y , std::int64_t ( 0 ) );
+		edges.block_max[ i ] = std::max ( across_x , std::int64_t ( 0 ) ) + std::max ( across_y , std::int64_t ( 0 ) );
+	}
+
+	// a pixel can only be covered if its center lies inside the snapped bounds
+	std::int64_t min_x = std::min ( { X[ 0 ] , X[ 1 ] , X[ 2 ] } );
+	std::int64_t max_x = std::max ( { X[ 0 ] , X[ 1 ] , X[ 2 ] } );
+	std::int64_t min_y = std::min ( { Y[ 0 ] , Y[ 1 ] , Y[ 2 ] } );
+	std::int64_t max_y = std::max ( { Y[ 0 ] , Y[ 1 ] , Y[ 2 ] } );
+	edges.bounds.x0 = static_cast< GLint >( ( min_x - half ) >> subpixel_bits );
+	edges.bounds.x1 = static_cast< GLint >( ( max_x - half ) >> subpixel_bits ) + 1;
+	edges.bounds.y0 = static_cast< GLint >( ( min_y - half ) >> subpixel_bits );
+	edges.bounds.y1 = static_cast< GLint >( ( max_y - half ) >> subpixel_bits ) + 1;
+	return true;
+}
+
+/**
+ * @brief
+ * incorporates work around for top-left rule
+ * @param edge_equation
+ * the calculated evaluation
+ * @param top_left
+ * if it passed the evaluation of top left rule
+ * @return
+ * the function will return true if the point is completely inside the edge or on a "top" or "left" edge, otherwise the function returns false
+*/
+bool GLPbo::PointInEdgeTopLeftOptimized ( std::int64_t edge_equation , bool top_left )
+{
+	return ( edge_equation > 0 || ( edge_equation == 0 && top_left == true ) ) ? true : false;
+}
+
+/**
+ * @brief
+ * implementing the point-in-triangle test can be rewritten to take advantage of the optimized PointInEdgeTopLeftOptimized test
+ * @param e0
+ * evaluated value for line 1
+ * @param e1
+ * evaluated value for line 2
+ * @param e2
+ * evaluated value for line 3
+ * @param top_left_e0
+ * if it passed the evaluation of top left rule  for line 1
+ * @param top_left_e1
+ * if it passed the evaluation of top left rule  for line 2
+ * @param top_left_e2
+ * if it passed the evaluation of top left rule  for line 3
+ * @return
+ * true if a point is inside the triangle , otherwise false
+*/
+bool GLPbo::PointInTriangleOptimized ( std::int64_t e0 , std::int64_t e1 , std::int64_t e2 , bool top_left_e0 , bool top_left_e1 , bool top_left_e2 )
+{
+	if( PointInEdgeTopLeftOptimized ( e0 , top_left_e0 ) &&
+		PointInEdgeTopLeftOptimized ( e1 , top_left_e1 ) &&
+		PointInEdgeTopLeftOptimized ( e2 , top_left_e2 ) )
+		return true;
+
+	return false;
+}
+
+/**
+ * @brief
+ * trivial reject and accept of a block_size x block_size block of fragments
+ * @param edges
+ * edge functions of the triangle
+ * @param corner
+ * the three edge functions at the top-left fragment of the block
+ * @return
+ * outside if the block is entirely outside one edge, inside if it is entirely
+ * inside all three edges, partial otherwise
+*/
+GLPbo::BlockCoverage GLPbo::ClassifyBlock ( Edges const& edges , std::int64_t const* corner )
+{
+	bool inside = true;
+	for( int i = 0 ; i < 3 ; ++i )
+	{
+		if( corner[ i ] + edges.block_max[ i ] - edges.bias[ i ] < 0 )
+		{
+			return BlockCoverage::outside;
+		}
+		inside = inside && corner[ i ] + edges.block_min[ i ] - edges.bias[ i ] >= 0;
+	}
+	return inside ? BlockCoverage::inside : BlockCoverage::partial;
+}
+
+/**
+ * @brief
+ * coverage kernel. Produces the edge functions of coverage_lanes adjacent
+ * fragments of a row with integer adds and tests them all with one sign-bit
+ * extraction: a fragment is inside when none of ( E - bias ) is negative.
+ * @param edges
+ * edge functions of the triangle
+ * @param span
+ * the three edge functions at the first fragment, advanced by coverage_lanes
+ * fragments on return
+ * @param e0 , e1 , e2
+ * user supplied arrays of coverage_lanes values filled with the edge functions,
+ * needed afterwards for the barycentric coordinates
+ * @param trivial_accept
+ * true if the span lies in a block that is known to be inside, the edge
+ * functions are then produced without testing them
+ * @return
+ * bit i is set if the i-th fragment of the span is inside the triangle
+*/
+unsigned int GLPbo::CoverageMask ( Edges const& edges , std::int64_t* span , std::int64_t* e0 , std::int64_t* e1 , std::int64_t* e2 , bool trivial_accept )
+{
+	std::int64_t* const out[ 3 ] = { e0 , e1 , e2 };
+	unsigned int const full = ( 1u << coverage_lanes ) - 1;
+
+#if defined( GLPBO_AVX2 )
+	__m256i outside_lo = _mm256_setzero_si256 ();
+	__m256i outside_hi = _mm256_setzero_si256 ();
+	for( int i = 0 ; i < 3 ; ++i )
+	{
+		__m256i base = _mm256_set1_epi64x ( span[ i ] );
+		__m256i bias = _mm256_set1_epi64x ( edges.bias[ i ] );
+		__m256i lo = _mm256_add_epi64 ( base , _mm256_load_si256 ( reinterpret_cast< __m256i const* >( edges.lane_offset[ i ] ) ) );
+		__m256i hi = _mm256_add_epi64 ( base , _mm256_load_si256 ( reinterpret_cast< __m256i const* >( edges.lane_offset[ i ] + 4 ) ) );
+		_mm256_store_si256 ( reinterpret_cast< __m256i* >( out[ i ] ) , lo );
+		_mm256_store_si256 ( reinterpret_cast< __m256i* >( out[ i ] + 4 ) , hi );
+		outside_lo = _mm256_or_si256 ( outside_lo , _mm256_sub_epi64 ( lo , bias ) );
+		outside_hi = _mm256_or_si256 ( outside_hi , _mm256_sub_epi64 ( hi , bias ) );
+		span[ i ] += edges.step_x[ i ] * coverage_lanes;
+	}
+	if( trivial_accept )
+	{
+		return full;
+	}
+	unsigned int outside = static_cast< unsigned int >( _mm256_movemask_pd ( _mm256_castsi256_pd ( outside_lo ) ) )
+		| static_cast< unsigned int >( _mm256_movemask_pd ( _mm256_castsi256_pd ( outside_hi ) ) ) << 4;
+	return ~outside & full;
+#elif defined( GLPBO_SSE2 )
+	__m128i outside_lo = _mm_setzero_si128 ();
+	__m128i outside_hi = _mm_setzero_si128 ();
+	for( int i = 0 ; i < 3 ; ++i )
+	{
+		__m128i base = _mm_set1_epi64x ( span[ i ] );
+		__m128i bias = _mm_set1_epi64x ( edges.bias[ i ] );
+		__m128i lo = _mm_add_epi64 ( base , _mm_load_si128 ( reinterpret_cast< __m128i const* >( edges.lane_offset[ i ] ) ) );
+		__m128i hi = _mm_add_epi64 ( base , _mm_load_si128 ( reinterpret_cast< __m128i const* >( edges.lane_offset[ i ] + 2 ) ) );
+		_mm_store_si128 ( reinterpret_cast< __m128i* >( out[ i ] ) , lo );
+		_mm_store_si128 ( reinterpret_cast< __m128i* >( out[ i ] + 2 ) , hi );
+		outside_lo = _mm_or_si128 ( outside_lo , _mm_sub_epi64 ( lo , bias ) );
+		outside_hi = _mm_or_si128 ( outside_hi , _mm_sub_epi64 ( hi , bias ) );
+		span[ i ] += edges.step_x[ i ] * coverage_lanes;
+	}
+	if( trivial_accept )
+	{
+		return full;
+	}
+	unsigned int outside = static_cast< unsigned int >( _mm_movemask_pd ( _mm_castsi128_pd ( outside_lo ) ) )
+		| static_cast< unsigned int >( _mm_movemask_pd ( _mm_castsi128_pd ( outside_hi ) ) ) << 2;
+	return ~outside & full;
+#else
+	unsigned int mask = full;
+	for( int i = 0 ; i < 3 ; ++i )
+	{
+		for( int lane = 0 ; lane < coverage_lanes ; ++lane )
+		{
+			out[ i ][ lane ] = span[ i ] + edges.lane_offset[ i ][ lane ];
+		}
+		span[ i ] += edges.step_x[ i ] * coverage_lanes;
+	}
+	if( trivial_accept )
+	{
+		return mask;
+	}
+	for( int lane = 0 ; lane < coverage_lanes ; ++lane )
+	{
+		if( !PointInTriangleOptimized ( e0[ lane ] , e1[ lane ] , e2[ lane ] , edges.bias[ 0 ] == 0 , edges.bias[ 1 ] == 0 , edges.bias[ 2 ] == 0 ) )
+		{
+			mask &= ~( 1u << lane );
+		}
+	}
+	return mask;
+#endif
+}
+
+/**
+ * @brief
+ * lanes of a span that are still left of the bounding box's right end
+ * @param remaining
+ * number of fragments left in the row
+ * @return
+ * mask with the lowest min ( remaining , coverage_lanes ) bits set
+*/
+unsigned int GLPbo::SpanMask ( int remaining )
+{
+	return remaining >= coverage_lanes ? ( 1u << coverage_lanes ) - 1 : ( 1u << remaining ) - 1;
+}
+
+/**
+ * @brief
+ * index of the lowest set bit
+ * @param mask
+ * non-zero lane mask
+ * @return
+ * lane number
+*/
+int GLPbo::LowestLane ( unsigned int mask )
+{
+#if defined( _MSC_VER )
+	unsigned long index;
+	_BitScanForward ( &index , mask );
+	return static_cast< int >( index );
+#else
+	return __builtin_ctz ( mask );
+#endif
+}
+
+/**
+ * @brief
+ * evaluates one edge function at the center of a pixel
+ * @param edges
+ * edge functions of the triangle
+ * @param edge
+ * which edge, 0 to 2
+ * @param x , y
+ * window coordinates of the pixel
+ * @return
+ * edge function in fixed point, positive inside the edge
+*/
+std::int64_t GLPbo::EvaluateFragment ( Edges const& edges , int edge , GLint x , GLint y )
+{
+	return edges.origin[ edge ] + x * edges.step_x[ edge ] + y * edges.step_y[ edge ];
+}
+
+/**
+ * @brief
+ * first step of a bresenham line at which the minor coordinate has moved
+ * more than n times. After k steps along the major axis the line has made
+ * ( 2 * dmin * k + dmaj - 1 ) / ( 2 * dmaj ) minor steps.
+ * @param n
+ * minor steps made so far
+ * @param dmaj , dmin
+ * length of the line along its major and minor axis, dmin <= dmaj
+ * @return
+ * the step, INT64_MAX for a line without minor steps
+*/
+std::int64_t NextMinorStep ( std::int64_t n , std::int64_t dmaj , std::int64_t dmin )
+{
+	return dmin ? ( 2 * dmaj * ( n + 1 ) - dmaj + 2 * dmin ) / ( 2 * dmin ) : INT64_MAX;
+}
+
+/**
+ * @brief
+ * Liang-Barsky clipping of a bresenham line against the scissor, in steps
+ * along its major axis. Each of the four sides of the scissor bounds the
+ * steps from one end, and as the minor coordinate never goes back, so do
+ * the ones across the line. The result is exact: the steps kept are the
+ * ones the unclipped line would have drawn inside the scissor.
+ * @param m0 , m_step , m_lo , m_hi
+ * start, direction and scissor range [ m_lo , m_hi ) of the major axis
+ * @param n0 , n_step , n_lo , n_hi
+ * start, direction and scissor range [ n_lo , n_hi ) of the minor axis
+ * @param dmaj , dmin
+ * length of the line along its major and minor axis, dmin <= dmaj
+ * @param first , last
+ * receive the range of steps inside the scissor
+ * @param minor
+ * receives the minor steps made before first
+ * @return
+ * false if no step is
+*/
+bool ClipLine ( int m0 , int m_step , int m_lo , int m_hi , int n0 , int n_step , int n_lo , int n_hi , int dmaj , int dmin , int& first , int& last , int& minor )
+{
+	// the end point itself is never drawn, but a point is
+	first = 0;
+	last = std::max ( dmaj - 1 , 0 );
+	minor = 0;
+
+	// most lines of a mesh lie within the tile
+	int const m1 = m0 + m_step * dmaj , n1 = n0 + n_step * dmin;
+	if( std::min ( m0 , m1 ) >= m_lo && std::max ( m0 , m1 ) < m_hi && std::min ( n0 , n1 ) >= n_lo && std::max ( n0 , n1 ) < n_hi )
+	{
+		return true;
+	}
+
+	std::int64_t lo = m_step > 0 ? m_lo - m0 : m0 - ( m_hi - 1 );
+	std::int64_t hi = m_step > 0 ? m_hi - 1 - m0 : m0 - m_lo;
+	std::int64_t begin = std::max<std::int64_t> ( first , lo ) , end = std::min<std::int64_t> ( last , hi );
+
+	// minor steps allowed inside the scissor
+	lo = n_step > 0 ? n_lo - n0 : n0 - ( n_hi - 1 );
+	hi = n_step > 0 ? n_hi - 1 - n0 : n0 - n_lo;
+	if( hi < 0 )
+	{
+		return false;
+	}
+	if( lo > 0 )
+	{
+		begin = std::max ( begin , NextMinorStep ( lo - 1 , dmaj , dmin ) );
+	}
+	end = std::min ( end , NextMinorStep ( hi , dmaj , dmin ) - 1 );
+	if( begin > end )
+	{
+		return false;
+	}
+	first = static_cast< int >( begin );
+	last = static_cast< int >( end );
+	minor = dmaj ? static_cast< int >( ( 2 * dmin * begin + dmaj - 1 ) / ( 2 * dmaj ) ) : 0;
+	return true;
+}
+
+/**
+ * @brief
+ * bresenham line drawing algorithm for if the line falls within octant 0347.
+ * The line is clipped to the scissor up front, which must lie within one
+ * tile as render_tile sets it, and then written straight into the rows of
+ * the tile.
+ * @param x1
+ * starting point x
+ * @param y1
+ * starting point y
+ * @param x2
+ * ending point x
+ * @param y2
+ * ending point y
+ * @param clr
+ * color of the line to be drawn
+*/
+void GLPbo::line_bresenham_octant0347 ( int x1 , int y1 , int x2 , int y2 , Color clr )
+{
+	int dx = x2 - x1 , dy = y2 - y1;
+	int xstep = ( dx < 0 ) ? -1 : 1;
+	int ystep = ( dy < 0 ) ? -1 : 1;
+	dx = ( dx < 0 ) ? -dx : dx;
+	dy = ( dy < 0 ) ? -dy : dy;
+	int first , last , n;
+	if( !ClipLine ( x1 , xstep , scissor.x0 , scissor.x1 , y1 , ystep , scissor.y0 , scissor.y1 , dx , dy , first , last , n ) )
+	{
+		return;
+	}
+	ThreadStatistics ().fragments += last - first + 1;
+
+	// the error term as it is after first steps
+	int d = 2 * dy * ( first + 1 ) - dx - 2 * dx * n , dmin = 2 * dy , dmaj = 2 * dy - 2 * dx;
+	std::ptrdiff_t const samples = framebuffer.samples , row = ystep * tile_size * samples;
+	Color* pixel = &framebuffer.color[ framebuffer.Index ( x1 + xstep * first , y1 + ystep * n ) ];
+	for( int k = first ; ; ++k )
+	{
+		std::fill_n ( pixel , samples , clr );
+		if( k == last )
+		{
+			break;
+		}
+		pixel += xstep * samples + ( ( d > 0 ) ? row : 0 );
+		d += ( d > 0 ) ? dmaj : dmin;
+	}
+}
+
+/**
+ * @brief
+ * bresenham line drawing algorithm for if the line falls within octant 1256.
+ * The line is clipped to the scissor up front like in octant 0347.
+ * @param x1
+ * starting point x
+ * @param y1
+ * starting point y
+ * @param x2
+ * ending point x
+ * @param y2
+ * ending point y
+ * @param clr
+ * color of the line to be drawn
+*/
+void GLPbo::line_bresenham_octant1256 ( GLint x1 , GLint y1 , GLint x2 , GLint y2 , GLPbo::Color draw_clr )
+{
+	int dx = x2 - x1 , dy = y2 - y1;
+	int xstep = ( dx < 0 ) ? -1 : 1;
+	int ystep = ( dy < 0 ) ? -1 : 1;
+	dx = ( dx < 0 ) ? -dx : dx;
+	dy = ( dy < 0 ) ? -dy : dy;
+	int first , last , n;
+	if( !ClipLine ( y1 , ystep , scissor.y0 , scissor.y1 , x1 , xstep , scissor.x0 , scissor.x1 , dy , dx , first , last , n ) )
+	{
+		return;
+	}
+	ThreadStatistics ().fragments += last - first + 1;
+
+	int d = 2 * dx * ( first + 1 ) - dy - 2 * dy * n , dmin = 2 * dx , dmaj = 2 * dx - 2 * dy;
+	std::ptrdiff_t const samples = framebuffer.samples , row = ystep * tile_size * samples;
+	Color* pixel = &framebuffer.color[ framebuffer.Index ( x1 + xstep * n , y1 + ystep * first ) ];
+	for( int k = first ; ; ++k )
+	{
+		std::fill_n ( pixel , samples , draw_clr );
+		if( k == last )
+		{
+			break;
+		}
+		pixel += row + ( ( d > 0 ) ? xstep * samples : 0 );
+		d += ( d > 0 ) ? dmaj : dmin;
+	}
+}
+
+/**
+ * @brief
+ * sets a color into the specified location in the pbo. ( x , y ) must lie in
+ * the viewport, triangles and lines are clipped before rasterization.
+ * @param x
+ * x-coordinate
+ * @param y
+ * y-coordinate
+ * @param clr
+ * color to set the pixel to
+*/
+void GLPbo::set_pixel ( int x , int y , Color clr )
+{
+	std::fill_n ( framebuffer.color.begin () + framebuffer.Index ( x , y ) , framebuffer.samples , clr );
+}
+
+/**
+ * @brief
+ * renders a line between 2 points using the bresenham line drawing algorithm
+ * @param x1
+ * starting point x
+ * @param y1
+ * starting point y
+ * @param x2
+ * ending point x
+ * @param y2
+ * ending point y
+ * @param draw_clr
+ * color of the line to be drawn
+*/
+void GLPbo::render_linebresenham ( GLint px0 , GLint py0 , GLint px1 , GLint py1 , GLPbo::Color draw_clr )
+{
+	GLint absX = abs ( px1 - px0 );
+	GLint absY = abs ( py1 - py0 );
+	if( absY <= absX )
+	{
+		line_bresenham_octant0347 ( px0 , py0 , px1 , py1 , draw_clr );
+	}
+	else
+	{
+		line_bresenham_octant1256 ( px0 , py0 , px1 , py1 , draw_clr );
+	}
+}
+
+
+/**
+ * @brief
+ * loads a .tex image, three ints for the width, the height and the bytes
+ * per texel followed by the texels as b , g , r rows, into the tiled layout
+ * and builds its mip chain by averaging 2x2 texels down to 1x1
+ * @param filename
+ * path of the image
+*/
+void GLPbo::Texture::ReadFile ( const std::string& filename )
+{
+	std::ifstream file ( filename , std::ios::binary );
+	int bytes_per_texel;
+	if( file )
+	{
+		format = Format::rgba8;
+		blocks.clear ();
+
+		// read first 12 bytes, i.e. 3 ints
+		file.read ( ( char* ) &twidth , sizeof ( int ) );
+		file.read ( ( char* ) &theight , sizeof ( int ) );
+		file.read ( ( char* ) &bytes_per_texel , sizeof ( int ) );
+		bytes_per_texel = std::max ( bytes_per_texel , 3 );
+
+		// read colors
+		std::vector<unsigned char> bytes ( static_cast< size_t >( twidth ) * theight * bytes_per_texel );
+		file.read ( ( char* ) bytes.data () , bytes.size () );
+
+		// lay out the chain, every level is a whole number of tiles so that
+		// all of them start on a cache line
+		levels.clear ();
+		size_t size = 0;
+		for( int w = twidth , h = theight ; w > 0 && h > 0 ; )
+		{
+			Level level{ w , h , ( w + 3 ) / 4 , size };
+			size += static_cast< size_t >( level.tiles_x ) * ( ( h + 3 ) / 4 ) * 16;
+			levels.push_back ( level );
+			if( w == 1 && h == 1 )
+			{
+				break;
+			}
+			// the shorter side stays at 1 until the longer one gets there
+			w = std::max ( w / 2 , 1 );
+			h = std::max ( h / 2 , 1 );
+		}
+		storage.assign ( size + 15 , Color{} );
+		size_t first = ( 16 - reinterpret_cast< std::uintptr_t >( storage.data () ) / sizeof ( Color ) % 16 ) % 16;
+		for( Level& level : levels )
+		{
+			level.first += first;
+		}
+
+		Level const& base = levels[ 0 ];
+		for( int y = 0; y < theight; ++y )
+		{
+			for( int x = 0; x < twidth; ++x )
+			{
+				unsigned char const* bgr = &bytes[ ( static_cast< size_t >( y ) * twidth + x ) * bytes_per_texel ];
+				storage[ base.first + base.Offset ( x , y ) ] = Color ( bgr[ 2 ] , bgr[ 1 ] , bgr[ 0 ] );
+			}
+		}
+
+		for( size_t l = 1 ; l < levels.size () ; ++l )
+		{
+			Level const& source = levels[ l - 1 ];
+			Level const& level = levels[ l ];
+			for( int y = 0; y < level.height; ++y )
+			{
+				for( int x = 0; x < level.width; ++x )
+				{
+					// an odd last row or column of the source is dropped
+					int x0 = std::min ( x * 2 , source.width - 1 ) , x1 = std::min ( x * 2 + 1 , source.width - 1 );
+					int y0 = std::min ( y * 2 , source.height - 1 ) , y1 = std::min ( y * 2 + 1 , source.height - 1 );
+					Color const c[ 4 ] = { storage[ source.first + source.Offset ( x0 , y0 ) ] , storage[ source.first + source.Offset ( x1 , y0 ) ] ,
+						storage[ source.first + source.Offset ( x0 , y1 ) ] , storage[ source.first + source.Offset ( x1 , y1 ) ] };
+					Color average;
+					for( int channel = 0 ; channel < 4 ; ++channel )
+					{
+						average.val[ channel ] = static_cast< GLubyte >( ( c[ 0 ].val[ channel ] + c[ 1 ].val[ channel ] + c[ 2 ].val[ channel ] + c[ 3 ].val[ channel ] + 2 ) / 4 );
+					}
+					storage[ level.first + level.Offset ( x , y ) ] = average;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief
+ * widens a 5:6:5 color of a compressed block to 8 bits per channel by
+ * repeating its top bits
+ * @param c
+ * the 5:6:5 color
+ * @return
+ * the opaque color
+*/
+GLPbo::Color Expand565 ( unsigned int c )
+{
+	unsigned int r = c >> 11 & 31 , g = c >> 5 & 63 , b = c & 31;
+	return GLPbo::Color ( static_cast< GLubyte >( r << 3 | r >> 2 ) , static_cast< GLubyte >( g << 2 | g >> 4 ) , static_cast< GLubyte >( b << 3 | b >> 2 ) );
+}
+
+/**
+ * @brief
+ * rounds a color to 5:6:5
+ * @param c
+ * the color, each channel in [0,255]
+ * @return
+ * the 5:6:5 color
+*/
+unsigned int Pack565 ( glm::vec3 const& c )
+{
+	glm::vec3 q = glm::round ( glm::clamp ( c , 0.0f , 255.0f ) * glm::vec3 ( 31.0f , 63.0f , 31.0f ) / 255.0f );
+	return static_cast< unsigned int >( q.r ) << 11 | static_cast< unsigned int >( q.g ) << 5 | static_cast< unsigned int >( q.b );
+}
+
+/**
+ * @brief
+ * the four colors a color block interpolates between its endpoints. With
+ * c0 > c1, or in a bc3 block, two colors lie between them; otherwise one
+ * lies halfway and the last is transparent black.
+ * @param c0 , c1
+ * the 5:6:5 endpoints
+ * @param four
+ * whether the block always has four colors, as in bc3
+ * @param palette
+ * receives the four colors
+*/
+void ColorPalette ( unsigned int c0 , unsigned int c1 , bool four , GLPbo::Color* palette )
+{
+	palette[ 0 ] = Expand565 ( c0 );
+	palette[ 1 ] = Expand565 ( c1 );
+	for( int channel = 0 ; channel < 3 ; ++channel )
+	{
+		int a = palette[ 0 ].val[ channel ] , b = palette[ 1 ].val[ channel ];
+		if( four || c0 > c1 )
+		{
+			palette[ 2 ].val[ channel ] = static_cast< GLubyte >( ( 2 * a + b ) / 3 );
+			palette[ 3 ].val[ channel ] = static_cast< GLubyte >( ( a + 2 * b ) / 3 );
+		}
+		else
+		{
+			palette[ 2 ].val[ channel ] = static_cast< GLubyte >( ( a + b ) / 2 );
+			palette[ 3 ].val[ channel ] = 0;
+		}
+	}
+	palette[ 2 ].a = 255;
+	palette[ 3 ].a = four || c0 > c1 ? 255 : 0;
+}
+
+/**
+ * @brief
+ * the eight alphas an alpha block interpolates between its endpoints.
+ * With a0 > a1 six lie between them, otherwise four do and the last two
+ * are 0 and 255.
+ * @param a0 , a1
+ * the endpoints
+ * @param palette
+ * receives the eight alphas
+*/
+void AlphaPalette ( unsigned int a0 , unsigned int a1 , unsigned int* palette )
+{
+	palette[ 0 ] = a0;
+	palette[ 1 ] = a1;
+	if( a0 > a1 )
+	{
+		for( unsigned int k = 1 ; k < 7 ; ++k )
+		{
+			palette[ k + 1 ] = ( ( 7 - k ) * a0 + k * a1 ) / 7;
+		}
+	}
+	else
+	{
+		for( unsigned int k = 1 ; k < 5 ; ++k )
+		{
+			palette[ k + 1 ] = ( ( 5 - k ) * a0 + k * a1 ) / 5;
+		}
+		palette[ 6 ] = 0;
+		palette[ 7 ] = 255;
+	}
+}
+
+/**
+ * @brief
+ * compresses the colors of a 4x4 tile to a bc1 color block. The endpoints
+ * are the extremes of the texels along their principal axis, every texel
+ * then takes the nearest of the four palette colors.
+ * @param texels
+ * the 16 texels, row by row
+ * @return
+ * the block, c0 and c1 in the low 32 bits and the 2 bit index of texel i
+ * at bit 32 + 2i
+*/
+std::uint64_t EncodeColorBlock ( GLPbo::Color const* texels )
+{
+	glm::vec3 colors[ 16 ];
+	glm::vec3 mean ( 0.0f );
+	for( int i = 0 ; i < 16 ; ++i )
+	{
+		colors[ i ] = glm::vec3 ( texels[ i ].r , texels[ i ].g , texels[ i ].b );
+		mean += colors[ i ];
+	}
+	mean /= 16.0f;
+
+	// principal axis by power iteration on the covariance
+	glm::mat3 covariance ( 0.0f );
+	for( glm::vec3 const& c : colors )
+	{
+		covariance += glm::outerProduct ( c - mean , c - mean );
+	}
+	glm::vec3 axis ( 1.0f );
+	for( int iteration = 0 ; iteration < 4 ; ++iteration )
+	{
+		axis = covariance * axis;
+		float length = glm::length ( axis );
+		axis = length > 0.0f ? axis / length : glm::vec3 ( 0.0f );
+	}
+	float lo = 0.0f , hi = 0.0f;
+	for( glm::vec3 const& c : colors )
+	{
+		lo = std::min ( lo , glm::dot ( c - mean , axis ) );
+		hi = std::max ( hi , glm::dot ( c - mean , axis ) );
+	}
+
+	// c0 > c1 selects four colors, c0 == c1 has only one anyway
+	unsigned int c0 = Pack565 ( mean + axis * hi ) , c1 = Pack565 ( mean + axis * lo );
+	if( c0 < c1 )
+	{
+		std::swap ( c0 , c1 );
+	}
+	GLPbo::Color palette[ 4 ];
+	ColorPalette ( c0 , c1 , false , palette );
+	int const choices = c0 > c1 ? 4 : 1;
+
+	std::uint64_t indices = 0;
+	for( int i = 0 ; i < 16 ; ++i )
+	{
+		int best = 0;
+		float best_error = 0.0f;
+		for( int k = 0 ; k < choices ; ++k )
+		{
+			glm::vec3 d = colors[ i ] - glm::vec3 ( palette[ k ].r , palette[ k ].g , palette[ k ].b );
+			float error = glm::dot ( d , d );
+			if( k == 0 || error < best_error )
+			{
+				best = k;
+				best_error = error;
+			}
+		}
+		indices |= static_cast< std::uint64_t >( best ) << ( 2 * i );
+	}
+	return c0 | static_cast< std::uint64_t >( c1 ) << 16 | indices << 32;
+}
+
+/**
+ * @brief
+ * compresses the alphas of a 4x4 tile to a bc3 alpha block, the extremes
+ * as endpoints with six alphas between them
+ * @param texels
+ * the 16 texels, row by row
+ * @return
+ * the block, a0 and a1 in the low 16 bits and the 3 bit index of texel i
+ * at bit 16 + 3i
+*/
+std::uint64_t EncodeAlphaBlock ( GLPbo::Color const* texels )
+{
+	unsigned int a0 = 0 , a1 = 255;
+	for( int i = 0 ; i < 16 ; ++i )
+	{
+		a0 = std::max< unsigned int > ( a0 , texels[ i ].a );
+		a1 = std::min< unsigned int > ( a1 , texels[ i ].a );
+	}
+	unsigned int palette[ 8 ];
+	AlphaPalette ( a0 , a1 , palette );
+
+	std::uint64_t indices = 0;
+	for( int i = 0 ; i < 16 && a0 > a1 ; ++i )
+	{
+		int best = 0;
+		for( int k = 1 ; k < 8 ; ++k )
+		{
+			if( std::abs ( static_cast< int >( palette[ k ] ) - texels[ i ].a ) < std::abs ( static_cast< int >( palette[ best ] ) - texels[ i ].a ) )
+			{
+				best = k;
+			}
+		}
+		indices |= static_cast< std::uint64_t >( best ) << ( 3 * i );
+	}
+	return a0 | a1 << 8 | indices << 16;
+}
+
+/**
+ * @brief
+ * block-compresses every level, each 4x4 tile of the tiled layout to one
+ * block. The texels are released, from then on Texel decodes the blocks.
+ * @param to
+ * bc1 or bc3, rgba8 leaves the texture as it is
+*/
+void GLPbo::Texture::Compress ( Format to )
+{
+	if( to == Format::rgba8 || format != Format::rgba8 || levels.empty () )
+	{
+		return;
+	}
+
+	// blocks have no alignment to keep, the levels start at block 0
+	size_t const base = levels[ 0 ].first;
+	for( Level& level : levels )
+	{
+		level.first -= base;
+	}
+	Level const& last = levels.back ();
+	size_t const block_cnt = last.first / 16 + static_cast< size_t >( last.tiles_x ) * ( ( last.height + 3 ) / 4 );
+	size_t const words = to == Format::bc3 ? 2 : 1;
+	blocks.assign ( block_cnt * words , 0 );
+
+	constexpr int job_blocks = 4096;
+	thread_pool.parallel_for ( static_cast< int >( ( block_cnt + job_blocks - 1 ) / job_blocks ) , [ & ] ( int job , int )
+	{
+		size_t end = std::min ( block_cnt , static_cast< size_t >( job + 1 ) * job_blocks );
+		for( size_t block = static_cast< size_t >( job ) * job_blocks ; block < end ; ++block )
+		{
+			Color const* texels = storage.data () + base + block * 16;
+			if( to == Format::bc3 )
+			{
+				blocks[ block * 2 ] = EncodeAlphaBlock ( texels );
+				blocks[ block * 2 + 1 ] = EncodeColorBlock ( texels );
+			}
+			else
+			{
+				blocks[ block ] = EncodeColorBlock ( texels );
+			}
+		}
+	} );
+
+	storage.clear ();
+	storage.shrink_to_fit ();
+	format = to;
+	static unsigned int compressions = 0;
+	blocks_id = ++compressions;
+}
+
+/**
+ * @brief
+ * decodes one block of a compressed texture
+ * @param block
+ * index of the block, the storage index of its first texel divided by 16
+ * @param texels
+ * receives the 16 texels, row by row
+*/
+void GLPbo::Texture::DecodeBlock ( size_t block , Color* texels ) const
+{
+	std::uint64_t color = format == Format::bc3 ? blocks[ block * 2 + 1 ] : blocks[ block ];
+	Color palette[ 4 ];
+	ColorPalette ( color & 0xFFFF , color >> 16 & 0xFFFF , format == Format::bc3 , palette );
+	for( int i = 0 ; i < 16 ; ++i )
+	{
+		texels[ i ] = palette[ color >> ( 32 + 2 * i ) & 3 ];
+	}
+
+	if( format == Format::bc3 )
+	{
+		std::uint64_t alpha = blocks[ block * 2 ];
+		unsigned int alphas[ 8 ];
+		AlphaPalette ( alpha & 0xFF , alpha >> 8 & 0xFF , alphas );
+		for( int i = 0 ; i < 16 ; ++i )
+		{
+			texels[ i ].a = static_cast< GLubyte >( alphas[ alpha >> ( 16 + 3 * i ) & 7 ] );
+		}
+	}
+}
+
+/**
+ * @brief
+ * memory taken by the texels of all levels, or by their blocks once
+ * compressed
+ * @return
+ * size in bytes
+*/
+size_t GLPbo::Texture::Bytes () const
+{
+	return storage.size () * sizeof ( Color ) + blocks.size () * sizeof ( std::uint64_t );
+}
+
+/**
+ * @brief
+ * reads a texel, coordinates outside the level are wrapped or clamped or
+ * give the border color
+ * @param level
+ * mip level to read
+ * @param x , y
+ * texel coordinates
+ * @return
+ * the texel
+*/
+GLPbo::Color GLPbo::Texture::Fetch ( Level const& level , int x , int y ) const
+{
+	switch( wrap )
+	{
+		case Wrap::repeat:
+			x %= level.width;
+			y %= level.height;
+			x += x < 0 ? level.width : 0;
+			y += y < 0 ? level.height : 0;
+			break;
+		case Wrap::clamp:
+			x = std::min ( std::max ( x , 0 ) , level.width - 1 );
+			y = std::min ( std::max ( y , 0 ) , level.height - 1 );
+			break;
+		case Wrap::border:
+			if( x < 0 || x >= level.width || y < 0 || y >= level.height )
+			{
+				return border;
+			}
+			break;
+	}
+	return Texel ( level.first + level.Offset ( x , y ) );
+}
+
+/**
+ * @brief
+ * reads a texel of the tiled layout. A compressed texture decodes the
+ * whole block of the texel into the calling thread's cache, where the
+ * neighbours a bilinear footprint or the next fragment needs are found
+ * without decoding it again.
+ * @param index
+ * storage index of the texel, level.first plus the level's Offset
+ * @return
+ * the texel
+*/
+GLPbo::Color GLPbo::Texture::Texel ( size_t index ) const
+{
+	if( format == Format::rgba8 )
+	{
+		return storage[ index ];
+	}
+
+	BlockCache& cache = block_cache;
+	if( cache.blocks_id != blocks_id )
+	{
+		cache.blocks_id = blocks_id;
+		std::fill ( std::begin ( cache.tag ) , std::end ( cache.tag ) , SIZE_MAX );
+	}
+	size_t block = index >> 4;
+	// hashed, so that the blocks above and below one another, a row of
+	// blocks apart, do not evict each other
+	size_t slot = static_cast< size_t >( ( block * 0x9E3779B97F4A7C15ull ) >> 58 ) & ( cache_blocks - 1 );
+	if( cache.tag[ slot ] != block )
+	{
+		DecodeBlock ( block , cache.texels[ slot ] );
+		cache.tag[ slot ] = block;
+	}
+	return cache.texels[ slot ][ index & 15 ];
+}
+
+/**
+ * @brief
+ * samples one level with the texture's filter
+ * @param level
+ * mip level to sample
+ * @param tex
+ * texture coordinates, [0,1] covers the image
+ * @return
+ * the color, each channel in [0,255]
+*/
+glm::vec3 GLPbo::Texture::Sample ( Level const& level , glm::vec2 const& tex ) const
+{
+	auto color = [ & ] ( int x , int y )
+	{
+		Color c = Fetch ( level , x , y );
+		return glm::vec3 ( c.r , c.g , c.b );
+	};
+	if( filter == Filter::nearest )
+	{
+		return color ( static_cast< int >( std::floor ( level.width * tex.x ) ) , static_cast< int >( std::floor ( level.height * tex.y ) ) );
+	}
+
+	// texel centres sit at half-integer coordinates
+	float u = level.width * tex.x - 0.5f;
+	float v = level.height * tex.y - 0.5f;
+	float x0 = std::floor ( u ) , y0 = std::floor ( v );
+	float ax = u - x0 , ay = v - y0;
+	int x = static_cast< int >( x0 ) , y = static_cast< int >( y0 );
+	return ( color ( x , y ) * ( 1.0f - ax ) + color ( x + 1 , y ) * ax ) * ( 1.0f - ay ) +
+		( color ( x , y + 1 ) * ( 1.0f - ax ) + color ( x + 1 , y + 1 ) * ax ) * ay;
+}
+
+/**
+ * @brief
+ * level of detail of a footprint, from how far the texture coordinates
+ * move per pixel in x and in y, the larger of the two in texels of level 0
+ * @param ddx , ddy
+ * screen-space derivatives of the texture coordinates
+ * @return
+ * log2 of the texels per pixel, 0 or less selects level 0
+*/
+float GLPbo::Texture::Lod ( glm::vec2 const& ddx , glm::vec2 const& ddy ) const
+{
+	glm::vec2 const size ( twidth , theight );
+	float rho = std::max ( glm::dot ( ddx * size , ddx * size ) , glm::dot ( ddy * size , ddy * size ) );
+	// log2 of the square root
+	return rho > 0.0f ? 0.5f * std::log2 ( rho ) : 0.0f;
+}
 
-		sub_tri_e0 += sub_tri_e0_inc_y;
-		sub_tri_e1 += sub_tri_e1_inc_y;
-		sub_tri_e2 += sub_tri_e2_inc_y;
+/**
+ * @brief
+ * samples the texture with its filter, mip filter and wrap mode
+ * @param tex
+ * texture coordinates, [0,1] covers the image
+ * @param lod
+ * level of detail from Lod, ignored without a mip filter
+ * @return
+ * the color, each channel in [0,255]
+*/
+glm::vec3 GLPbo::Texture::GetColor ( const glm::vec2& tex , float lod ) const
+{
+	if( levels.empty () )
+	{
+		return glm::vec3 ( border.r , border.g , border.b );
 	}
-
-	return false;
+	if( mip_filter == MipFilter::none || lod <= 0.0f )
+	{
+		return Sample ( levels[ 0 ] , tex );
+	}
+	float const last = static_cast< float >( levels.size () - 1 );
+	if( mip_filter == MipFilter::nearest )
+	{
+		return Sample ( levels[ static_cast< size_t >( std::min ( std::floor ( lod + 0.5f ) , last ) ) ] , tex );
+	}
+	lod = std::min ( lod , last );
+	size_t level = static_cast< size_t >( lod );
+	float blend = lod - level;
+	glm::vec3 color = Sample ( levels[ level ] , tex );
+	return blend > 0.0f ? color * ( 1.0f - blend ) + Sample ( levels[ level + 1 ] , tex ) * blend : color;
 }
 
-// render faceted
-bool GLPbo::render_faceted ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Model& model , int index0 , int index1 , int index2 )
+/**
+ * @brief
+ * GetColor for count texture coordinates with the same level of detail,
+ * the fragments of one triangle under an affine projection
+ * @param tex
+ * texture coordinates
+ * @param colors
+ * receives the colors
+ * @param count
+ * number of coordinates
+ * @param lod
+ * level of detail from Lod, ignored without a mip filter
+*/
+void GLPbo::Texture::GetColors ( glm::vec2 const* tex , glm::vec3* colors , int count , float lod ) const
 {
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
+	if( levels.empty () )
 	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
-	};
-	if( normal.z <= 0 )
+		std::fill ( colors , colors + count , glm::vec3 ( border.r , border.g , border.b ) );
+		return;
+	}
+	if( mip_filter == MipFilter::none || lod <= 0.0f )
 	{
-		++culled_;
-		return false;
+		Sample ( levels[ 0 ] , tex , colors , count );
+		return;
 	}
-
-	glm::vec3 line0 = EdgeEqnTopLeft ( p1 , p2 );
-	glm::vec3 line1 = EdgeEqnTopLeft ( p2 , p0 );
-	glm::vec3 line2 = EdgeEqnTopLeft ( p0 , p1 );
-
-	float min_x = floor ( std::min ( { p0.x, p1.x ,p2.x } ) );
-	float max_x = ceil ( std::max ( { p0.x, p1.x ,p2.x } ) );
-	float min_y = floor ( std::min ( { p0.y, p1.y ,p2.y } ) );
-	float max_y = ceil ( std::max ( { p0.y, p1.y ,p2.y } ) );
-
-	bool top_left_e0 , top_left_e1 , top_left_e2 ;
-	float evaluation0 = EvaluateFragment ( line0 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e0 );
-	float evaluation1 = EvaluateFragment ( line1 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e1 );
-	float evaluation2 = EvaluateFragment ( line2 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e2 );
-
-	float double_area_triangle = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p2.x - p0.x ) * ( p1.y - p0.y );
-
-	float sub_tri_e0 = evaluation0 / double_area_triangle;
-	float sub_tri_e1 = evaluation1 / double_area_triangle;
-	float sub_tri_e2 = evaluation2 / double_area_triangle;
-
-	float sub_tri_e0_inc_x = line0.x / double_area_triangle;
-	float sub_tri_e1_inc_x = line1.x / double_area_triangle;
-	float sub_tri_e2_inc_x = line2.x / double_area_triangle;
-
-	float sub_tri_e0_inc_y = line0.y / double_area_triangle;
-	float sub_tri_e1_inc_y = line1.y / double_area_triangle;
-	float sub_tri_e2_inc_y = line2.y / double_area_triangle;
-
-	glm::vec3 tri_normal = glm::cross ( ( model.pm[ index1 ] - model.pm[ index0 ] ) , ( model.pm[ index2 ] - model.pm[ index0 ] ) );
-
-	for( int y = ( int ) min_y ; y < ( int ) max_y ; ++y )
+	float const last = static_cast< float >( levels.size () - 1 );
+	if( mip_filter == MipFilter::nearest )
 	{
-		float Hevaluation0 = evaluation0;
-		float Hevaluation1 = evaluation1;
-		float Hevaluation2 = evaluation2;
-
-		float Hsub_tri_e0 = sub_tri_e0;
-		float Hsub_tri_e1 = sub_tri_e1;
-		float Hsub_tri_e2 = sub_tri_e2;
-
-		for( int x = ( int ) min_x ; x < ( int ) max_x ; ++x )
+		Sample ( levels[ static_cast< size_t >( std::min ( std::floor ( lod + 0.5f ) , last ) ) ] , tex , colors , count );
+		return;
+	}
+	lod = std::min ( lod , last );
+	size_t level = static_cast< size_t >( lod );
+	float blend = lod - level;
+	Sample ( levels[ level ] , tex , colors , count );
+	if( blend > 0.0f )
+	{
+		constexpr int chunk = 64;
+		glm::vec3 upper[ chunk ];
+		for( int i = 0 ; i < count ; i += chunk )
 		{
-			if( PointInTriangleOptimized ( Hevaluation0 , Hevaluation1 , Hevaluation2 , { x + 0.5f , y + 0.5f, 0 } , { 0,0 } , top_left_e0 , top_left_e1 , top_left_e2 ) )
+			int n = std::min ( chunk , count - i );
+			Sample ( levels[ level + 1 ] , tex + i , upper , n );
+			for( int k = 0 ; k < n ; ++k )
 			{
-				float z_value = Hsub_tri_e0 * p0.z + Hsub_tri_e1 * p1.z + Hsub_tri_e2 * p2.z;
-				glm::vec3 tri_point = Hsub_tri_e0 * model.pm[ index0 ] + Hsub_tri_e1 * model.pm[ index1 ] + Hsub_tri_e2 * model.pm[ index2 ];
-
-				float light = Calculate_Light ( point_light , tri_point , tri_normal );
-				set_pixel ( x , y , z_value , { static_cast< GLubyte >( light * 255.0f ) , static_cast< GLubyte > ( light * 255.0f ) ,static_cast< GLubyte >( light * 255.0f ) , 255 } );
+				colors[ i + k ] = colors[ i + k ] * ( 1.0f - blend ) + upper[ k ] * blend;
 			}
-			Hevaluation0 += line0.x;
-			Hevaluation1 += line1.x;
-			Hevaluation2 += line2.x;
-
-			Hsub_tri_e0 += sub_tri_e0_inc_x;
-			Hsub_tri_e1 += sub_tri_e1_inc_x;
-			Hsub_tri_e2 += sub_tri_e2_inc_x;
-
 		}
-		evaluation0 += line0.y;
-		evaluation1 += line1.y;
-		evaluation2 += line2.y;
-
-		sub_tri_e0 += sub_tri_e0_inc_y;
-		sub_tri_e1 += sub_tri_e1_inc_y;
-		sub_tri_e2 += sub_tri_e2_inc_y;
 	}
-
-	return false;
 }
 
-// render texture faceted
-bool GLPbo::render_texture_faceted ( glm::vec3 const& p0 , glm::vec3 const& p1 , glm::vec3 const& p2 , Model& model , int index0 , int index1 , int index2 , glm::vec2 texture0 , glm::vec2 texture1 , glm::vec2 texture2 )
+/**
+ * @brief
+ * samples one level at count texture coordinates at once. The lanes run
+ * the same arithmetic as the single coordinate Sample, so the results match
+ * it exactly. Texel coordinates are kept as floats, which is exact for
+ * images up to 4096 texels on a side.
+ * @param level
+ * mip level to sample
+ * @param tex
+ * texture coordinates
+ * @param colors
+ * receives the colors
+ * @param count
+ * number of coordinates
+*/
+void GLPbo::Texture::Sample ( Level const& level , glm::vec2 const* tex , glm::vec3* colors , int count ) const
 {
-	glm::vec3 P1P0 = p1 - p0;
-	glm::vec3 P2P0 = p2 - p0;
-	glm::vec3 normal =
-	{
-		P1P0.y * P2P0.z - P1P0.z * P2P0.y,
-		P1P0.z * P2P0.x - P1P0.x * P2P0.z,
-		P1P0.x * P2P0.y - P1P0.y * P2P0.x
-	};
-	if( normal.z <= 0 )
+	int i = 0;
+	if( format != Format::rgba8 )
 	{
-		++culled_;
-		return false;
+		// there are no texels to gather from, the blocks are decoded one
+		// texel at a time through the cache
+		for( ; i < count ; ++i )
+		{
+			colors[ i ] = Sample ( level , tex[ i ] );
+		}
+		return;
 	}
 
-	glm::vec3 line0 = EdgeEqnTopLeft ( p1 , p2 );
-	glm::vec3 line1 = EdgeEqnTopLeft ( p2 , p0 );
-	glm::vec3 line2 = EdgeEqnTopLeft ( p0 , p1 );
-
-	float min_x = floor ( std::min ( { p0.x, p1.x ,p2.x } ) );
-	float max_x = ceil ( std::max ( { p0.x, p1.x ,p2.x } ) );
-	float min_y = floor ( std::min ( { p0.y, p1.y ,p2.y } ) );
-	float max_y = ceil ( std::max ( { p0.y, p1.y ,p2.y } ) );
-
-	bool top_left_e0 , top_left_e1 , top_left_e2 ;
-	float evaluation0 = EvaluateFragment ( line0 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e0 );
-	float evaluation1 = EvaluateFragment ( line1 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e1 );
-	float evaluation2 = EvaluateFragment ( line2 , { min_x + 0.5f , min_y + 0.5f,0 } , top_left_e2 );
-
-	float double_area_triangle = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p2.x - p0.x ) * ( p1.y - p0.y );
-
-	float sub_tri_e0 = evaluation0 / double_area_triangle;
-	float sub_tri_e1 = evaluation1 / double_area_triangle;
-	float sub_tri_e2 = evaluation2 / double_area_triangle;
-
-	float sub_tri_e0_inc_x = line0.x / double_area_triangle;
-	float sub_tri_e1_inc_x = line1.x / double_area_triangle;
-	float sub_tri_e2_inc_x = line2.x / double_area_triangle;
-
-	float sub_tri_e0_inc_y = line0.y / double_area_triangle;
-	float sub_tri_e1_inc_y = line1.y / double_area_triangle;
-	float sub_tri_e2_inc_y = line2.y / double_area_triangle;
-
-	glm::vec3 tri_normal = glm::cross ( ( model.pm[ index1 ] - model.pm[ index0 ] ) , ( model.pm[ index2 ] - model.pm[ index0 ] ) );
-
-	for( int y = ( int ) min_y ; y < ( int ) max_y ; ++y )
+#if defined( GLPBO_AVX2 ) || defined( GLPBO_SSE2 )
+#if defined( GLPBO_AVX2 )
+	constexpr int lanes = 8;
+	using vec = __m256;
+	using ivec = __m256i;
+#define VSET _mm256_set1_ps
+#define VADD _mm256_add_ps
+#define VSUB _mm256_sub_ps
+#define VMUL _mm256_mul_ps
+#define VMIN _mm256_min_ps
+#define VMAX _mm256_max_ps
+#define VAND _mm256_and_ps
+#define VANDNOT _mm256_andnot_ps
+#define VOR _mm256_or_ps
+#define VLE( a , b ) _mm256_cmp_ps ( a , b , _CMP_LE_OQ )
+#define VFLOOR _mm256_floor_ps
+#define VSTORE _mm256_storeu_ps
+#define VTOINT _mm256_cvttps_epi32
+#define VTOFLOAT _mm256_cvtepi32_ps
+#define ISET _mm256_set1_epi32
+#define IAND _mm256_and_si256
+#define ISRL _mm256_srli_epi32
+	auto gather = [ & ] ( ivec index )
 	{
-		float Hevaluation0 = evaluation0;
-		float Hevaluation1 = evaluation1;
-		float Hevaluation2 = evaluation2;
-
-		float Hsub_tri_e0 = sub_tri_e0;
-		float Hsub_tri_e1 = sub_tri_e1;
-		float Hsub_tri_e2 = sub_tri_e2;
+		return _mm256_i32gather_epi32 ( reinterpret_cast< int const* >( storage.data () + level.first ) , index , 4 );
+	};
+#else
+	constexpr int lanes = 4;
+	using vec = __m128;
+	using ivec = __m128i;
+#define VSET _mm_set1_ps
+#define VADD _mm_add_ps
+#define VSUB _mm_sub_ps
+#define VMUL _mm_mul_ps
+#define VMIN _mm_min_ps
+#define VMAX _mm_max_ps
+#define VAND _mm_and_ps
+#define VANDNOT _mm_andnot_ps
+#define VOR _mm_or_ps
+#define VLE( a , b ) _mm_cmple_ps ( a , b )
+#define VSTORE _mm_storeu_ps
+#define VTOINT _mm_cvttps_epi32
+#define VTOFLOAT _mm_cvtepi32_ps
+#define ISET _mm_set1_epi32
+#define IAND _mm_and_si128
+#define ISRL _mm_srli_epi32
+	// SSE2 has no floor, truncate and step down where that rounded up
+	auto VFLOOR = [] ( vec x )
+	{
+		vec t = _mm_cvtepi32_ps ( _mm_cvttps_epi32 ( x ) );
+		return _mm_sub_ps ( t , _mm_and_ps ( _mm_cmpgt_ps ( t , x ) , _mm_set1_ps ( 1.0f ) ) );
+	};
+	auto gather = [ & ] ( ivec index )
+	{
+		alignas( 16 ) int lane[ 4 ];
+		_mm_store_si128 ( reinterpret_cast< __m128i* >( lane ) , index );
+		Color const* texels = storage.data () + level.first;
+		return _mm_set_epi32 ( texels[ lane[ 3 ] ].raw , texels[ lane[ 2 ] ].raw , texels[ lane[ 1 ] ].raw , texels[ lane[ 0 ] ].raw );
+	};
+#endif
 
-		for( int x = ( int ) min_x ; x < ( int ) max_x ; ++x )
+	{
+		vec const zero = VSET ( 0.0f );
+		vec const width = VSET ( static_cast< float >( level.width ) ) , height = VSET ( static_cast< float >( level.height ) );
+		vec const last_x = VSET ( static_cast< float >( level.width - 1 ) ) , last_y = VSET ( static_cast< float >( level.height - 1 ) );
+		vec const row = VSET ( static_cast< float >( level.tiles_x ) );
+		vec const border_r = VSET ( border.r ) , border_g = VSET ( border.g ) , border_b = VSET ( border.b );
+
+		// texel ( x , y ) of every lane, x and y hold whole numbers
+		auto fetch = [ & ] ( vec x , vec y , vec& r , vec& g , vec& b )
 		{
-			if( PointInTriangleOptimized ( Hevaluation0 , Hevaluation1 , Hevaluation2 , { x + 0.5f , y + 0.5f, 0 } , { 0,0 } , top_left_e0 , top_left_e1 , top_left_e2 ) )
+			vec inside = VSET ( 0.0f );
+			if( wrap == Wrap::repeat )
 			{
+				// the quotient is rounded, so the remainder can be off by one period
+				x = VSUB ( x , VMUL ( VFLOOR ( VMUL ( x , VSET ( 1.0f / level.width ) ) ) , width ) );
+				y = VSUB ( y , VMUL ( VFLOOR ( VMUL ( y , VSET ( 1.0f / level.height ) ) ) , height ) );
+				x = VADD ( VSUB ( x , VAND ( VLE ( width , x ) , width ) ) , VANDNOT ( VLE ( zero , x ) , width ) );
+				y = VADD ( VSUB ( y , VAND ( VLE ( height , y ) , height ) ) , VANDNOT ( VLE ( zero , y ) , height ) );
+			}
+			else if( wrap == Wrap::border )
+			{
+				inside = VAND ( VAND ( VLE ( zero , x ) , VLE ( x , last_x ) ) , VAND ( VLE ( zero , y ) , VLE ( y , last_y ) ) );
+			}
+			x = VMIN ( VMAX ( x , zero ) , last_x );
+			y = VMIN ( VMAX ( y , zero ) , last_y );
+
+			// Offset, with the tile and the texel within it split off by floor
+			vec tile_x = VFLOOR ( VMUL ( x , VSET ( 0.25f ) ) ) , tile_y = VFLOOR ( VMUL ( y , VSET ( 0.25f ) ) );
+			vec offset = VADD ( VMUL ( VADD ( VMUL ( tile_y , row ) , tile_x ) , VSET ( 16.0f ) ) ,
+				VADD ( VMUL ( VSUB ( y , VMUL ( tile_y , VSET ( 4.0f ) ) ) , VSET ( 4.0f ) ) , VSUB ( x , VMUL ( tile_x , VSET ( 4.0f ) ) ) ) );
+			ivec texel = gather ( VTOINT ( offset ) );
+			ivec const mask = ISET ( 0xff );
+			r = VTOFLOAT ( IAND ( texel , mask ) );
+			g = VTOFLOAT ( IAND ( ISRL ( texel , 8 ) , mask ) );
+			b = VTOFLOAT ( IAND ( ISRL ( texel , 16 ) , mask ) );
+			if( wrap == Wrap::border )
+			{
+				r = VOR ( VAND ( inside , r ) , VANDNOT ( inside , border_r ) );
+				g = VOR ( VAND ( inside , g ) , VANDNOT ( inside , border_g ) );
+				b = VOR ( VAND ( inside , b ) , VANDNOT ( inside , border_b ) );
+			}
+		};
 
-				glm::vec2 color = Hsub_tri_e0 * texture0 + Hsub_tri_e1 * texture1 + Hsub_tri_e2 * texture2;
-				glm::vec3 tex_color = texture.GetColor ( color );
-
-				float z_value = Hsub_tri_e0 * p0.z + Hsub_tri_e1 * p1.z + Hsub_tri_e2 * p2.z;
-				glm::vec3 tri_point = Hsub_tri_e0 * model.pm[ index0 ] + Hsub_tri_e1 * model.pm[ index1 ] + Hsub_tri_e2 * model.pm[ index2 ];
-				float light = Calculate_Light ( point_light , tri_point , tri_normal );
-				set_pixel ( x , y , z_value , { static_cast< GLubyte >( light * tex_color.x ) , static_cast< GLubyte > ( light * tex_color.y ) ,static_cast< GLubyte >( light * tex_color.z ) , 255 } );
+		for( ; i + lanes <= count ; i += lanes )
+		{
+			alignas( 32 ) float lane_u[ lanes ] , lane_v[ lanes ];
+			for( int k = 0 ; k < lanes ; ++k )
+			{
+				lane_u[ k ] = tex[ i + k ].x;
+				lane_v[ k ] = tex[ i + k ].y;
 			}
-			Hevaluation0 += line0.x;
-			Hevaluation1 += line1.x;
-			Hevaluation2 += line2.x;
+			vec u = VMUL ( width , *reinterpret_cast< vec const* >( lane_u ) );
+			vec v = VMUL ( height , *reinterpret_cast< vec const* >( lane_v ) );
 
-			Hsub_tri_e0 += sub_tri_e0_inc_x;
-			Hsub_tri_e1 += sub_tri_e1_inc_x;
-			Hsub_tri_e2 += sub_tri_e2_inc_x;
+			vec r , g , b;
+			if( filter == Filter::nearest )
+			{
+				fetch ( VFLOOR ( u ) , VFLOOR ( v ) , r , g , b );
+			}
+			else
+			{
+				u = VSUB ( u , VSET ( 0.5f ) );
+				v = VSUB ( v , VSET ( 0.5f ) );
+				vec x0 = VFLOOR ( u ) , y0 = VFLOOR ( v );
+				vec ax = VSUB ( u , x0 ) , ay = VSUB ( v , y0 );
+				vec bx = VSUB ( VSET ( 1.0f ) , ax ) , by = VSUB ( VSET ( 1.0f ) , ay );
+				vec x1 = VADD ( x0 , VSET ( 1.0f ) ) , y1 = VADD ( y0 , VSET ( 1.0f ) );
+				vec r00 , g00 , b00 , r10 , g10 , b10 , r01 , g01 , b01 , r11 , g11 , b11;
+				fetch ( x0 , y0 , r00 , g00 , b00 );
+				fetch ( x1 , y0 , r10 , g10 , b10 );
+				fetch ( x0 , y1 , r01 , g01 , b01 );
+				fetch ( x1 , y1 , r11 , g11 , b11 );
+				auto blend = [ & ] ( vec c00 , vec c10 , vec c01 , vec c11 )
+				{
+					return VADD ( VMUL ( VADD ( VMUL ( c00 , bx ) , VMUL ( c10 , ax ) ) , by ) , VMUL ( VADD ( VMUL ( c01 , bx ) , VMUL ( c11 , ax ) ) , ay ) );
+				};
+				r = blend ( r00 , r10 , r01 , r11 );
+				g = blend ( g00 , g10 , g01 , g11 );
+				b = blend ( b00 , b10 , b01 , b11 );
+			}
 
+			alignas( 32 ) float out[ 3 ][ lanes ];
+			VSTORE ( out[ 0 ] , r );
+			VSTORE ( out[ 1 ] , g );
+			VSTORE ( out[ 2 ] , b );
+			for( int k = 0 ; k < lanes ; ++k )
+			{
+				colors[ i + k ] = { out[ 0 ][ k ] , out[ 1 ][ k ] , out[ 2 ][ k ] };
+			}
 		}
-		evaluation0 += line0.y;
-		evaluation1 += line1.y;
-		evaluation2 += line2.y;
-
-		sub_tri_e0 += sub_tri_e0_inc_y;
-		sub_tri_e1 += sub_tri_e1_inc_y;
-		sub_tri_e2 += sub_tri_e2_inc_y;
 	}
-
-	return false;
+#undef VSET
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VMIN
+#undef VMAX
+#undef VAND
+#undef VANDNOT
+#undef VOR
+#undef VLE
+#undef VFLOOR
+#undef VSTORE
+#undef VTOINT
+#undef VTOFLOAT
+#undef ISET
+#undef IAND
+#undef ISRL
+#endif
+
+	for( ; i < count ; ++i )
+	{
+		colors[ i ] = Sample ( level , tex[ i ] );
+	}
 }
 
 /**
  * @brief
- * edge equation calculations for top-left rule
- * @param p0
- * starting point
- * @param p1
- * end point
- * @return
- * if evaluation falls within the edge
+ * joins the workers if cleanup () was never called
 */
-glm::vec3 GLPbo::EdgeEqnTopLeft ( glm::vec3 const& p0 , glm::vec3 const& p1 )
+GLPbo::ThreadPool::~ThreadPool ()
 {
-	return { p0.y - p1.y , p1.x - p0.x , p0.x * p1.y - p1.x * p0.y };
+	stop ();
 }
 
 /**
  * @brief
- * incorporates work around for top-left rule
- * @param edge_equation
- * the calculated evaluation
- * @param arbitrary_point
- * fragment to be check with
- * @param increment
- * increment on the x or y axis
- * @param top_left
- * if it passed the evaluation of top left rule
- * @return
- * the function will return true if the point is completely inside the edge or on a "top" or "left" edge, otherwise the function returns false
+ * spawns count - 1 workers, the thread calling parallel_for is the last one
+ * @param count
+ * total number of threads, all of them active to begin with
 */
-bool GLPbo::PointInEdgeTopLeftOptimized ( float edge_equation , glm::vec3 arbitrary_point , glm::vec2 increment , bool& top_left )
+void GLPbo::ThreadPool::start ( unsigned int count )
 {
-	return ( edge_equation > 0 || ( edge_equation == 0 && top_left == true ) ) ? true : false;
+	stop ();
+	quit = false;
+	for( unsigned int id = 1 ; id < count ; ++id )
+	{
+		workers.emplace_back ( &ThreadPool::worker_loop , this , id );
+	}
+	active_cnt = count;
 }
 
 /**
  * @brief
- * implementing the point-in-triangle test can be rewritten to take advantage of the optimized PointInEdgeTopLeftOptimized test
- * @param e0
- * evaluated value for line 1
- * @param e1
- * evaluated value for line 2
- * @param e2
- * evaluated value for line 3
- * @param arbitrary_point
- * fragment to be check with
- * @param increment
- * increment on the x or y axis
- * @param top_left_e0
- * if it passed the evaluation of top left rule  for line 1
- * @param top_left_e1
- * if it passed the evaluation of top left rule  for line 2
- * @param top_left_e2
- * if it passed the evaluation of top left rule  for line 3
- * @return
- * true if a point is inside the triangle , otherwise false
+ * wakes every worker up to quit and waits for them
 */
-bool GLPbo::PointInTriangleOptimized ( float const& e0 , float const& e1 , float const& e2 , glm::vec3 const& arbitrary_point , glm::vec2 increment , bool& top_left_e0 , bool& top_left_e1 , bool& top_left_e2 )
+void GLPbo::ThreadPool::stop ()
 {
-	if( PointInEdgeTopLeftOptimized ( e0 , arbitrary_point , increment , top_left_e0 ) &&
-		PointInEdgeTopLeftOptimized ( e1 , arbitrary_point , increment , top_left_e1 ) &&
-		PointInEdgeTopLeftOptimized ( e2 , arbitrary_point , increment , top_left_e2 ) )
-		return true;
-
-	return false;
+	{
+		std::lock_guard<std::mutex> lock ( mutex );
+		quit = true;
+	}
+	cv_work.notify_all ();
+	for( std::thread& worker : workers )
+	{
+		worker.join ();
+	}
+	workers.clear ();
+	active_cnt = 1;
 }
 
 /**
  * @brief
- * calculate the evaluation value of a window coordinate to see if its inside or outside an edge
- * @param evaluate_point
- * line to be check with
- * @param arbitrary_point
- * edge to check against
- * @param top_left
- * user provide empty boolean to be filled , return true if pass the top left rules
- * @return
+ * limits how many threads take jobs in the following parallel_for calls
+ * @param count
+ * clamped to [1, size ()]
 */
-float GLPbo::EvaluateFragment ( glm::vec3 evaluate_point , glm::vec3 const& arbitrary_point , bool& top_left )
+void GLPbo::ThreadPool::set_active ( unsigned int count )
 {
-	top_left = ( evaluate_point.x != 0.0 ) ? ( evaluate_point.x > 0.0 ? true : false ) : ( evaluate_point.y < 0.0 ? true : false );
-	return ( evaluate_point.x * arbitrary_point.x ) + ( evaluate_point.y * arbitrary_point.y ) + evaluate_point.z ;
+	std::lock_guard<std::mutex> lock ( mutex );
+	active_cnt = std::max ( 1u , std::min ( count , size () ) );
 }
 
 /**
  * @brief
- * bresenham line drawing algorithm for if the line falls within octant 0347
- * @param x1
- * starting point x
- * @param y1
- * starting point y
- * @param x2
- * ending point x
- * @param y2
- * ending point y
- * @param clr
- * color of the line to be drawn
+ * hands out the jobs [0, count) to the active threads, jobs are picked up
+ * in ascending order but may complete in any order
+ * @param count
+ * number of jobs
+ * @param fn
+ * called as fn ( index , worker ) where worker is in [0, active ())
 */
-void GLPbo::line_bresenham_octant0347 ( int x1 , int y1 , int x2 , int y2 , Color clr )
+void GLPbo::ThreadPool::parallel_for ( int count , std::function<void ( int , int )> const& fn )
 {
-	int dx = x2 - x1 , dy = y2 - y1;
-	int xstep = ( dx < 0 ) ? -1 : 1;
-	int ystep = ( dy < 0 ) ? -1 : 1;
-	dx = ( dx < 0 ) ? -dx : dx;
-	dy = ( dy < 0 ) ? -dy : dy;
-	int d = 2 * dy - dx , dmin = 2 * dy , dmaj = 2 * dy - 2 * dx;
-	GLPbo::set_pixel ( x1 , y1 , clr );
-	while( --dx > 0 )
+	if( active_cnt <= 1 || count <= 1 )
 	{
-		y1 += ( d > 0 ) ? ystep : 0;
-		d += ( d > 0 ) ? dmaj : dmin;
-		x1 += xstep;
-		GLPbo::set_pixel ( x1 , y1 , clr );
+		for( int i = 0 ; i < count ; ++i )
+		{
+			fn ( i , 0 );
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock ( mutex );
+		job = &fn;
+		job_cnt = count;
+		next_job = 0;
+		pending = active_cnt - 1;
+		++generation;
 	}
+	cv_work.notify_all ();
+
+	run_jobs ( 0 );
+
+	std::unique_lock<std::mutex> lock ( mutex );
+	cv_done.wait ( lock , [ this ] { return pending == 0; } );
+	job = nullptr;
 }
 
 /**
  * @brief
- * bresenham line drawing algorithm for if the line falls within octant 1256
- * @param x1
- * starting point x
- * @param y1
- * starting point y
- * @param x2
- * ending point x
- * @param y2
- * ending point y
- * @param clr
- * color of the line to be drawn
+ * body of every worker thread, sleeps until the next parallel_for
+ * @param id
+ * worker index, 0 is reserved for the calling thread
 */
-void GLPbo::line_bresenham_octant1256 ( GLint x1 , GLint y1 , GLint x2 , GLint y2 , GLPbo::Color draw_clr )
+void GLPbo::ThreadPool::worker_loop ( unsigned int id )
 {
-	int dx = x2 - x1 , dy = y2 - y1;
-	int xstep = ( dx < 0 ) ? -1 : 1;
-	int ystep = ( dy < 0 ) ? -1 : 1;
-	dx = ( dx < 0 ) ? -dx : dx;
-	dy = ( dy < 0 ) ? -dy : dy;
-	int d = 2 * dx - dy , dmin = 2 * dx , dmaj = 2 * dx - 2 * dy;
-	GLPbo::set_pixel ( x1 , y1 , draw_clr );
-	while( --dy > 0 )
+	unsigned int seen = 0;
+	for( ;; )
 	{
-		x1 += ( d > 0 ) ? xstep : 0;
-		d += ( d > 0 ) ? dmaj : dmin;
-		y1 += ystep;
-		GLPbo::set_pixel ( x1 , y1 , draw_clr );
+		{
+			std::unique_lock<std::mutex> lock ( mutex );
+			cv_work.wait ( lock , [ this , seen ] { return quit || generation != seen; } );
+			if( quit )
+			{
+				return;
+			}
+			seen = generation;
+			// parked workers skip this round
+			if( id >= active_cnt )
+			{
+				continue;
+			}
+		}
+
+		run_jobs ( id );
+
+		std::lock_guard<std::mutex> lock ( mutex );
+		if( --pending == 0 )
+		{
+			cv_done.notify_one ();
+		}
 	}
 }
 
 /**
  * @brief
- * does scizzoring check and sets a color into the specified location in the pbo
- * @param x
- * x-coordinate
- * @param y
- * y-coordinate
- * @param clr
- * color to set the pixel to
+ * takes jobs off the shared counter until none are left
+ * @param id
+ * index of the thread running the jobs
 */
-void GLPbo::set_pixel ( int x , int y , Color clr )
+void GLPbo::ThreadPool::run_jobs ( unsigned int id )
 {
-	if( x < 0 || x >= GLPbo::width || y < 0 || y >= GLPbo::height )
-	{
-		return;
-	}
-	else
+	for( int i = next_job++ ; i < job_cnt ; i = next_job++ )
 	{
-		int locate = ( GLPbo::width * y ) + x;
-		GLPbo::ptr_to_pbo[ locate ] = clr;
+		( *job )( i , static_cast< int >( id ) );
 	}
 }
 
-void GLPbo::set_pixel ( int x , int y , float z , Color clr )
+#if defined( GLPBO_TRACE )
+/**
+ * @brief
+ * nanoseconds since trace_epoch
+*/
+std::int64_t TraceNow ()
 {
+	return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now () - trace_epoch ).count ();
+}
 
-
-	if( x < 0 || x >= GLPbo::width || y < 0 || y >= GLPbo::height )
-	{
-		return;
-	}
-	else if( z > depth_buffer[ y * width + x ] )
+/**
+ * @brief
+ * buffer of the calling thread, created the first time the thread records
+*/
+TraceBuffer& ThreadTraceBuffer ()
+{
+	if( !trace_buffer )
 	{
-		depth_buffer[ y * width + x ] = z ;
-		int locate = ( GLPbo::width * y ) + x;
-		GLPbo::ptr_to_pbo[ locate ] = clr;
+		std::lock_guard<std::mutex> lock ( trace_mutex );
+		trace_buffers.emplace_back ( new TraceBuffer{ static_cast< int >( trace_buffers.size () ) , {} } );
+		trace_buffer = trace_buffers.back ().get ();
 	}
+	return *trace_buffer;
+}
 
+/**
+ * @brief
+ * starts timing a stage, a single relaxed load when nothing is recorded
+ * @param stage
+ * name of the stage, must outlive the recording
+*/
+GLPbo::Trace::Scope::Scope ( char const* stage ) : name{ stage } , start{ trace_recording.load ( std::memory_order_relaxed ) ? TraceNow () : -1 }
+{
 }
 
 /**
  * @brief
- * renders a line between 2 points using the bresenham line drawing algorithm
- * @param x1
- * starting point x
- * @param y1
- * starting point y
- * @param x2
- * ending point x
- * @param y2
- * ending point y
- * @param draw_clr
- * color of the line to be drawn
+ * ends the stage and adds it to the track of the calling thread
 */
-void GLPbo::render_linebresenham ( GLint px0 , GLint py0 , GLint px1 , GLint py1 , GLPbo::Color draw_clr )
+GLPbo::Trace::Scope::~Scope ()
 {
-	GLint absX = abs ( px1 - px0 );
-	GLint absY = abs ( py1 - py0 );
-	if( absY <= absX )
-	{
-		line_bresenham_octant0347 ( px0 , py0 , px1 , py1 , draw_clr );
-	}
-	else
+	if( start >= 0 )
 	{
-		line_bresenham_octant1256 ( px0 , py0 , px1 , py1 , draw_clr );
+		ThreadTraceBuffer ().events.push_back ( { name , start , TraceNow () - start } );
 	}
 }
 
-void GLPbo::clear_depth_buffer ()
+/**
+ * @brief
+ * records the next frames emulate () renders. Must be called by the thread
+ * that calls emulate (), which becomes the main track of the trace
+ * @param file
+ * path of the JSON file
+ * @param frames
+ * number of frames
+*/
+void GLPbo::Trace::start ( std::string const& file , int frames )
 {
-	std::fill ( depth_buffer.begin () , depth_buffer.end () , 0.0f );
+	ThreadTraceBuffer ();
+	trace_file = file;
+	trace_frames_left = frames;
 }
 
-void GLPbo::Texture::ReadFile ( const std::string& filename )
+/**
+ * @brief
+ * begins the recording with the first of its frames and ends it after the
+ * last. Between frames every worker is idle, so the buffers are cleared
+ * without locking
+*/
+void GLPbo::Trace::next_frame ()
 {
-	std::ifstream file ( filename , std::ios::binary );
-	int bytes_per_texel;
-	if( file )
+	if( trace_frames_left > 0 )
 	{
-		// read first 12 bytes, i.e. 3 ints
-		file.read ( ( char* ) &twidth , sizeof ( int ) );
-		file.read ( ( char* ) &theight , sizeof ( int ) );
-		file.read ( ( char* ) &bytes_per_texel , sizeof ( int ) );
-
-		// read colors
-		unsigned char b , g , r;
-		for( int i = 0; i < twidth * theight; ++i )
+		if( !trace_recording )
 		{
-			file.read ( ( char* ) &b , 1 );
-			file.read ( ( char* ) &g , 1 );
-			file.read ( ( char* ) &r , 1 );
-			data.emplace_back ( ( int ) r , ( int ) g , ( int ) b );
+			for( std::unique_ptr<TraceBuffer>& buffer : trace_buffers )
+			{
+				buffer->events.clear ();
+			}
+			trace_recording = true;
 		}
+		--trace_frames_left;
+	}
+	else if( trace_recording )
+	{
+		finish ();
 	}
 }
 
-glm::vec3 GLPbo::Texture::GetColor ( const glm::vec2& tex )
+/**
+ * @brief
+ * writes the recorded events as complete events , one track per thread ,
+ * with timestamps in microseconds as the trace event format wants them
+*/
+void GLPbo::Trace::finish ()
 {
-	int x = static_cast< int >( std::floor ( twidth * tex.x ) );
-	int y = static_cast< int >( std::floor ( theight * tex.y ) );
-	if( x >= 0 && x < twidth && y >= 0 && y < theight )
+	if( !trace_recording )
+	{
+		return;
+	}
+	trace_recording = false;
+	trace_frames_left = 0;
+
+	std::ofstream file ( trace_file );
+	if( !file )
+	{
+		std::cerr << "unable to write the trace to " << trace_file << std::endl;
+		return;
+	}
+	size_t count = 0;
+	file << std::fixed << std::setprecision ( 3 ) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	std::lock_guard<std::mutex> lock ( trace_mutex );
+	for( std::unique_ptr<TraceBuffer> const& buffer : trace_buffers )
 	{
-		return data[ y * twidth + x ];
+		file << ( buffer->tid ? ",\n" : "\n" ) << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->tid
+			<< ",\"args\":{\"name\":\"" << ( buffer->tid ? "worker " + std::to_string ( buffer->tid ) : std::string ( "main" ) ) << "\"}}";
+		for( TraceEvent const& event : buffer->events )
+		{
+			file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->tid
+				<< ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+		}
+		count += buffer->events.size ();
 	}
-	return { 255, 255, 255 };
+	file << "\n]}\n";
+	std::cout << "trace of " << count << " events written to " << trace_file << std::endl;
 }
+#endif
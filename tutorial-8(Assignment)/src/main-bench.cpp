@@ -0,0 +1,307 @@
+/*!
+@file    main-bench.cpp
+@author  Jia Min / j.jiamin@digipen.edu
+@date    17/10/2026
+This file times GLPbo::emulate() over every combination of render mode, mesh,
+frame size and thread count, on the headless build. Every combination is
+rendered for a number of warm-up frames that are not timed, then for a number
+of timed frames. The results are written as JSON, one combination per line,
+so that the runs of two versions can be compared with diff.
+
+usage : bench [ -c scene ] [ -m modes ] [ -s sizes ] [ -t threads ] [ -u frames ] [ -n frames ] [ -o file ]
+  -c  scene listing the meshes, ../scenes/ass-1.scn by default
+  -m  comma separated mode numbers in the order the W key cycles through them,
+      all modes by default
+  -s  comma separated frame sizes, 640x480,1000x1000,1920x1080 by default
+  -t  comma separated thread counts, 1 and every power of two up to the
+      hardware threads by default
+  -u  warm-up frames per combination, 5 by default
+  -n  timed frames per combination, 20 by default
+  -o  file the JSON is written to, stdout by default
+*//*__________________________________________________________________________*/
+
+/*                                                                   includes
+----------------------------------------------------------------------------- */
+#include <glpbo.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+/*                                                         type declarations
+----------------------------------------------------------------------------- */
+struct Size {
+  GLsizei width, height;
+};
+
+/*                                                      function declarations
+----------------------------------------------------------------------------- */
+static std::vector<std::string> split(std::string const& list);
+static bool parse_sizes(std::string const& list, std::vector<Size>& sizes);
+static bool parse_numbers(std::string const& list, int min, int max, std::vector<int>& numbers);
+static std::vector<std::pair<std::string, int>> load_scene(std::string const& scene);
+static std::string escape(std::string const& text);
+
+/*                                                      function definitions
+----------------------------------------------------------------------------- */
+/*  _________________________________________________________________________ */
+/*! main
+@param int argc
+@param char** argv
+command line options, see the file header
+@return int
+0 when every combination was run, non-zero otherwise.
+*/
+int main(int argc, char** argv) {
+  std::string scene = "../scenes/ass-1.scn", output;
+  std::string mode_list, size_list = "640x480,1000x1000,1920x1080", thread_list;
+  int warmup = 5, frames = 20;
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "-c") && has_value) {
+      scene = argv[++i];
+    } else if (!std::strcmp(argv[i], "-m") && has_value) {
+      mode_list = argv[++i];
+    } else if (!std::strcmp(argv[i], "-s") && has_value) {
+      size_list = argv[++i];
+    } else if (!std::strcmp(argv[i], "-t") && has_value) {
+      thread_list = argv[++i];
+    } else if (!std::strcmp(argv[i], "-u") && has_value) {
+      warmup = std::atoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "-n") && has_value) {
+      frames = std::atoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "-o") && has_value) {
+      output = argv[++i];
+    } else {
+      std::cerr << "usage : " << argv[0] << " [ -c scene ] [ -m modes ] [ -s sizes ] [ -t threads ] [ -u frames ] [ -n frames ] [ -o file ]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  unsigned int const hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<Size> sizes;
+  std::vector<int> modes, threads;
+  if (mode_list.empty()) {
+    for (int mode = 0; mode < GLPbo::mode_count(); ++mode) {
+      modes.push_back(mode);
+    }
+  }
+  if (thread_list.empty()) {
+    for (unsigned int count = 1; count < hardware_threads; count *= 2) {
+      threads.push_back(count);
+    }
+    threads.push_back(hardware_threads);
+  }
+  if (!parse_sizes(size_list, sizes) ||
+      (!mode_list.empty() && !parse_numbers(mode_list, 0, GLPbo::mode_count() - 1, modes)) ||
+      (!thread_list.empty() && !parse_numbers(thread_list, 1, hardware_threads, threads)) ||
+      warmup < 0 || frames <= 0) {
+    std::cerr << "invalid modes, sizes, thread counts or frame counts" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // the log of GLPbo goes to stderr so that stdout only carries the JSON
+  std::cout.rdbuf(std::cerr.rdbuf());
+  std::FILE* file = output.empty() ? stdout : std::fopen(output.c_str(), "w");
+  if (!file) {
+    std::cerr << "unable to open " << output << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  GLHelper::width = sizes.front().width;
+  GLHelper::height = sizes.front().height;
+  GLHelper::title = "bench";
+  GLPbo::init(GLHelper::width, GLHelper::height);
+  std::vector<std::pair<std::string, int>> meshes = load_scene(scene);
+  if (meshes.empty()) {
+    std::cerr << "no mesh of " << scene << " could be loaded" << std::endl;
+    GLPbo::cleanup();
+    return EXIT_FAILURE;
+  }
+
+  std::fprintf(file, "{\n  \"hardware_threads\": %u,\n  \"warmup_frames\": %d,\n  \"timed_frames\": %d,\n  \"results\": [\n",
+               hardware_threads, warmup, frames);
+  bool first = true;
+  std::vector<double> times(frames);
+  for (Size const& size : sizes) {
+    GLPbo::resize(size.width, size.height);
+    for (std::pair<std::string, int> const& mesh : meshes) {
+      for (int mode : modes) {
+        for (int count : threads) {
+          GLPbo::select(mode, mesh.second);
+          GLPbo::thread_pool.set_active(count);
+          for (int frame = 0; frame < warmup; ++frame) {
+            GLHelper::update_time(1.0);
+            GLPbo::emulate();
+          }
+          for (int frame = 0; frame < frames; ++frame) {
+            GLHelper::update_time(1.0);
+            auto start = std::chrono::steady_clock::now();
+            GLPbo::emulate();
+            times[frame] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+          }
+          // the counters of the last frame stand for all of them, the
+          // model does not move unless R was pressed
+          GLPbo::PipelineStatistics const& stats = GLPbo::statistics();
+
+          std::vector<double> sorted = times;
+          std::sort(sorted.begin(), sorted.end());
+          double mean = 0.0, variance = 0.0;
+          for (double time : times) {
+            mean += time / frames;
+          }
+          for (double time : times) {
+            variance += (time - mean) * (time - mean) / frames;
+          }
+          double median = frames % 2 ? sorted[frames / 2] : (sorted[frames / 2 - 1] + sorted[frames / 2]) / 2.0;
+          // rates in millions per second at the median frame time
+          double per_second = 1000.0 / median / 1.0e6;
+          std::string histogram;
+          for (int bucket = 0; bucket < GLPbo::PipelineStatistics::histogram_buckets; ++bucket) {
+            histogram += (bucket ? ", " : "") + std::to_string(stats.pixels_per_triangle[bucket]);
+          }
+
+          std::fprintf(file,
+                       "%s    { \"mode\": \"%s\", \"mesh\": \"%s\", \"width\": %d, \"height\": %d, \"threads\": %d, "
+                       "\"frame_ms\": { \"min\": %.4f, \"median\": %.4f, \"mean\": %.4f, \"stddev\": %.4f, \"max\": %.4f }, "
+                       "\"vertices\": %llu, \"primitives\": %llu, \"clipped\": %llu, \"culled\": %llu, \"pixels\": %llu, "
+                       "\"depth_passed\": %llu, \"depth_failed\": %llu, \"fragments\": %llu, \"texture_samples\": %llu, "
+                       "\"pixels_per_triangle\": [ %s ], "
+                       "\"mtris_per_s\": %.3f, \"mpixels_per_s\": %.3f, \"mfragments_per_s\": %.3f }",
+                       first ? "" : ",\n", GLPbo::mode_name(mode), escape(mesh.first).c_str(), size.width, size.height, count,
+                       sorted.front(), median, mean, std::sqrt(variance), sorted.back(),
+                       static_cast<unsigned long long>(stats.vertices), static_cast<unsigned long long>(stats.primitives),
+                       static_cast<unsigned long long>(stats.clipped), static_cast<unsigned long long>(stats.culled),
+                       static_cast<unsigned long long>(stats.pixels), static_cast<unsigned long long>(stats.depth_passed),
+                       static_cast<unsigned long long>(stats.depth_failed), static_cast<unsigned long long>(stats.fragments),
+                       static_cast<unsigned long long>(stats.texture_samples), histogram.c_str(),
+                       stats.primitives * per_second, static_cast<double>(size.width) * size.height * per_second, stats.fragments * per_second);
+          std::fflush(file);
+          first = false;
+          std::cerr << size.width << "x" << size.height << " " << mesh.first << " " << GLPbo::mode_name(mode)
+                    << " " << count << " threads : " << median << " ms" << std::endl;
+        }
+      }
+    }
+  }
+  std::fprintf(file, "\n  ]\n}\n");
+
+  GLPbo::cleanup();
+  bool written = !std::ferror(file);
+  if (file != stdout) {
+    written = std::fclose(file) == 0 && written;
+  }
+  return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*  _________________________________________________________________________ */
+/*! split
+@param std::string const& list
+comma separated items
+@return std::vector<std::string>
+the items, empty ones included.
+*/
+static std::vector<std::string> split(std::string const& list) {
+  std::vector<std::string> items;
+  std::istringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    items.push_back(item);
+  }
+  return items;
+}
+
+/*  _________________________________________________________________________ */
+/*! parse_sizes
+@param std::string const& list
+comma separated sizes such as 640x480
+@param std::vector<Size>& sizes
+receives the sizes
+@return bool
+false if a size is malformed or not positive.
+*/
+static bool parse_sizes(std::string const& list, std::vector<Size>& sizes) {
+  for (std::string const& item : split(list)) {
+    Size size{};
+    char separator = 0;
+    std::istringstream stream(item);
+    if (!(stream >> size.width >> separator >> size.height) || separator != 'x' || size.width <= 0 || size.height <= 0) {
+      return false;
+    }
+    sizes.push_back(size);
+  }
+  return !sizes.empty();
+}
+
+/*  _________________________________________________________________________ */
+/*! parse_numbers
+@param std::string const& list
+comma separated numbers
+@param int min, int max
+range every number has to be in
+@param std::vector<int>& numbers
+receives the numbers
+@return bool
+false if a number is malformed or out of range.
+*/
+static bool parse_numbers(std::string const& list, int min, int max, std::vector<int>& numbers) {
+  for (std::string const& item : split(list)) {
+    char* end = nullptr;
+    long number = std::strtol(item.c_str(), &end, 10);
+    if (item.empty() || *end || number < min || number > max) {
+      return false;
+    }
+    numbers.push_back(static_cast<int>(number));
+  }
+  return !numbers.empty();
+}
+
+/*  _________________________________________________________________________ */
+/*! load_scene
+@param std::string const& scene
+file with the name of one mesh of ../meshes per line
+@return std::vector<std::pair<std::string, int>>
+name and index into GLPbo::all_model_data of every mesh that could be loaded.
+Meshes GLPbo::init() already loaded are not loaded again.
+*/
+static std::vector<std::pair<std::string, int>> load_scene(std::string const& scene) {
+  std::vector<std::pair<std::string, int>> meshes;
+  std::ifstream file(scene);
+  if (!file) {
+    std::cerr << "unable to open " << scene << std::endl;
+    return meshes;
+  }
+  std::string name;
+  while (file >> name) {
+    std::string path = "../meshes/" + name + ".obj";
+    auto loaded = std::find_if(GLPbo::all_model_data.begin(), GLPbo::all_model_data.end(),
+                               [&path](std::pair<std::string, GLPbo::Model> const& model) { return model.first == path; });
+    if (loaded != GLPbo::all_model_data.end()) {
+      meshes.emplace_back(name, static_cast<int>(loaded - GLPbo::all_model_data.begin()));
+    } else if (GLPbo::load_model(path)) {
+      meshes.emplace_back(name, static_cast<int>(GLPbo::all_model_data.size()) - 1);
+    } else {
+      std::cerr << "unable to load " << path << ", skipped" << std::endl;
+    }
+  }
+  return meshes;
+}
+
+/*  _________________________________________________________________________ */
+/*! escape
+@param std::string const& text
+@return std::string
+text with the quotes and backslashes escaped for a JSON string.
+*/
+static std::string escape(std::string const& text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
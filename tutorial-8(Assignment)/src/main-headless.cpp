@@ -0,0 +1,377 @@
+/*!
+@file    main-headless.cpp
+@author  Jia Min / j.jiamin@digipen.edu
+@date    17/10/2026
+This file drives GLPbo without a window or OpenGL context, for batch runs on
+machines without a display. Frames are rendered into memory and written as
+PPM or PNG images, or as raw RGBA to stdout.
+The meshes are loaded with DPML, which only ships as a Windows library, so
+headless.vcxproj is the one build there is. The renderer itself needs no
+x86 intrinsics, GLPbo falls back to scalar code without SSE2.
+
+usage : headless [ -w width ] [ -h height ] [ -n frames ] [ -k keys ] [ -o file ] [ -t trace ]
+  -w , -h  size of the frames , 1000 x 1000 by default like main-pbo.cpp
+  -n       frames to render , 1 by default
+  -k       keys pressed one after the other before the frames are rendered ,
+           e.g. -k WWA selects the third render mode with 4 samples per pixel
+  -o       file the last frame is written to , .png for PNG and PPM otherwise.
+           With a pattern such as frame%03d.ppm , one %d with an optional zero
+           padded width and %% for a percent sign , every frame is written ,
+           and - writes every frame to stdout as raw RGBA , top row first
+  -t       file the stages of the -n frames are traced to as chrome://tracing
+           JSON , needs a build with GLPBO_TRACE
+*//*__________________________________________________________________________*/
+
+/*                                                                   includes
+----------------------------------------------------------------------------- */
+#include <glpbo.h>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#if defined( _WIN32 )
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+/*                                                      function declarations
+----------------------------------------------------------------------------- */
+static void render();
+static bool press(char key);
+static bool write_ppm(std::FILE* file);
+static bool write_png(std::FILE* file);
+static bool frame_path(std::string const& pattern, int frame, std::string& path, bool& numbered);
+static bool write_frame(std::string const& name, int frame);
+
+/*                                                      function definitions
+----------------------------------------------------------------------------- */
+/*  _________________________________________________________________________ */
+/*! main
+@param int argc
+@param char** argv
+command line options, see the file header
+@return int
+0 when every frame was rendered and written, non-zero otherwise.
+*/
+int main(int argc, char** argv) {
+  GLint width = 1000, height = 1000;
+  int frames = 1;
+  std::string keys, output, trace;
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "-w") && has_value) {
+      width = std::atoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "-h") && has_value) {
+      height = std::atoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "-n") && has_value) {
+      frames = std::atoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "-k") && has_value) {
+      keys = argv[++i];
+    } else if (!std::strcmp(argv[i], "-o") && has_value) {
+      output = argv[++i];
+    } else if (!std::strcmp(argv[i], "-t") && has_value) {
+      trace = argv[++i];
+    } else {
+      std::cerr << "usage : " << argv[0] << " [ -w width ] [ -h height ] [ -n frames ] [ -k keys ] [ -o file ] [ -t trace ]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (width <= 0 || height <= 0 || frames <= 0) {
+    std::cerr << "frame size and count must be positive" << std::endl;
+    return EXIT_FAILURE;
+  }
+  bool every_frame = output == "-";
+  std::string path;
+  if (!output.empty() && !every_frame && !frame_path(output, 0, path, every_frame)) {
+    std::cerr << "-o takes at most one %d , such as frame%03d.ppm" << std::endl;
+    return EXIT_FAILURE;
+  }
+#if !defined( GLPBO_TRACE )
+  if (!trace.empty()) {
+    std::cerr << "-t needs a build with GLPBO_TRACE" << std::endl;
+    return EXIT_FAILURE;
+  }
+#endif
+
+  // stdout carries the frames, the log goes to stderr
+  if (output == "-") {
+    std::cout.rdbuf(std::cerr.rdbuf());
+#if defined( _WIN32 )
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+  }
+
+  GLHelper::width = width;
+  GLHelper::height = height;
+  GLHelper::title = "headless";
+  GLPbo::init(GLHelper::width, GLHelper::height);
+
+  // the first frame sets up the model's state, keys act on the frames after
+  render();
+  for (char key : keys) {
+    if (!press(key)) {
+      std::cerr << "no key " << key << std::endl;
+      GLPbo::cleanup();
+      return EXIT_FAILURE;
+    }
+  }
+
+#if defined( GLPBO_TRACE )
+  if (!trace.empty()) {
+    GLPbo::Trace::start(trace, frames);
+  }
+#endif
+
+  double total_ms = 0.0;
+  bool written = true;
+  for (int frame = 0; frame < frames && written; ++frame) {
+    auto start = std::chrono::steady_clock::now();
+    render();
+    total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!output.empty() && (every_frame || frame + 1 == frames)) {
+      written = write_frame(output, frame);
+    }
+  }
+
+  std::cout << GLHelper::status << std::endl;
+  std::cout << frames << " frames , " << total_ms / frames << " ms per frame" << std::endl;
+  GLPbo::cleanup();
+  return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*  _________________________________________________________________________ */
+/*! render
+@param none
+@return none
+Renders one frame into GLPbo::ptr_to_pbo, advancing the clock like the
+update() of main-pbo.cpp.
+*/
+static void render() {
+  GLHelper::update_time(1.0);
+  GLPbo::emulate();
+}
+
+/*  _________________________________________________________________________ */
+/*! press
+@param char key
+letter of the key, upper or lower case
+@return bool
+false if GLPbo does not react to the key.
+Holds the key down for one frame and releases it for the next, since
+GLPbo::emulate() acts when a key goes down.
+*/
+static bool press(char key) {
+  GLboolean* state = nullptr;
+  switch (key) {
+    case 'A': case 'a': state = &GLHelper::keystateA; break;
+    case 'C': case 'c': state = &GLHelper::keystateC; break;
+    case 'K': case 'k': state = &GLHelper::keystateK; break;
+    case 'M': case 'm': state = &GLHelper::keystateM; break;
+    case 'R': case 'r': state = &GLHelper::keystateR; break;
+    case 'T': case 't': state = &GLHelper::keystateT; break;
+    case 'V': case 'v': state = &GLHelper::keystateV; break;
+    case 'W': case 'w': state = &GLHelper::keystateW; break;
+    default: return false;
+  }
+  *state = GL_TRUE;
+  render();
+  *state = GL_FALSE;
+  render();
+  return true;
+}
+
+/*  _________________________________________________________________________ */
+/*! write_ppm
+@param std::FILE* file
+open binary file
+@return bool
+false if writing failed.
+Writes the frame as a binary PPM. The PBO holds the bottom row first, as
+GL textures do, so rows are written in reverse.
+*/
+static bool write_ppm(std::FILE* file) {
+  std::fprintf(file, "P6\n%d %d\n255\n", GLPbo::width, GLPbo::height);
+  std::vector<unsigned char> row(GLPbo::width * 3);
+  for (GLint y = GLPbo::height - 1; y >= 0; --y) {
+    GLPbo::Color const* src = GLPbo::ptr_to_pbo + static_cast<size_t>(y) * GLPbo::width;
+    for (GLint x = 0; x < GLPbo::width; ++x) {
+      row[x * 3] = src[x].r;
+      row[x * 3 + 1] = src[x].g;
+      row[x * 3 + 2] = src[x].b;
+    }
+    if (std::fwrite(row.data(), 1, row.size(), file) != row.size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*  _________________________________________________________________________ */
+/*! write_png
+@param std::FILE* file
+open binary file
+@return bool
+false if writing failed.
+Writes the frame as an RGB PNG, top row first. The image data is kept in
+stored deflate blocks, which needs no compression library; the files are
+as large as a PPM.
+*/
+static bool write_png(std::FILE* file) {
+  static std::uint32_t crc_table[256];
+  if (!crc_table[1]) {
+    for (std::uint32_t n = 0; n < 256; ++n) {
+      std::uint32_t c = n;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      crc_table[n] = c;
+    }
+  }
+  auto put32 = [](std::vector<unsigned char>& out, std::uint32_t v) {
+    out.insert(out.end(), { static_cast<unsigned char>(v >> 24), static_cast<unsigned char>(v >> 16),
+                            static_cast<unsigned char>(v >> 8), static_cast<unsigned char>(v) });
+  };
+  // length, type, data and the crc of type and data
+  auto chunk = [&](char const* type, std::vector<unsigned char> const& data) {
+    std::vector<unsigned char> out;
+    put32(out, static_cast<std::uint32_t>(data.size()));
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 4; i < out.size(); ++i) {
+      crc = crc_table[(crc ^ out[i]) & 0xFF] ^ (crc >> 8);
+    }
+    put32(out, crc ^ 0xFFFFFFFFu);
+    return std::fwrite(out.data(), 1, out.size(), file) == out.size();
+  };
+
+  // every row is filter type 0 followed by its pixels
+  size_t const row_bytes = 1 + static_cast<size_t>(GLPbo::width) * 3;
+  std::vector<unsigned char> raw(row_bytes * GLPbo::height);
+  for (GLint y = 0; y < GLPbo::height; ++y) {
+    GLPbo::Color const* src = GLPbo::ptr_to_pbo + static_cast<size_t>(GLPbo::height - 1 - y) * GLPbo::width;
+    unsigned char* dst = &raw[y * row_bytes];
+    *dst++ = 0;
+    for (GLint x = 0; x < GLPbo::width; ++x) {
+      *dst++ = src[x].r;
+      *dst++ = src[x].g;
+      *dst++ = src[x].b;
+    }
+  }
+
+  // zlib stream of stored blocks of at most 65535 bytes, then the adler32 of raw
+  std::vector<unsigned char> idat = { 0x78, 0x01 };
+  idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+  for (size_t offset = 0; ; ) {
+    size_t size = std::min<size_t>(raw.size() - offset, 65535);
+    bool last = offset + size == raw.size();
+    idat.insert(idat.end(), { static_cast<unsigned char>(last), static_cast<unsigned char>(size), static_cast<unsigned char>(size >> 8),
+                              static_cast<unsigned char>(~size), static_cast<unsigned char>(~size >> 8) });
+    idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + size);
+    offset += size;
+    if (last) {
+      break;
+    }
+  }
+  std::uint32_t a = 1, b = 0;
+  for (unsigned char byte : raw) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  put32(idat, b << 16 | a);
+
+  std::vector<unsigned char> ihdr;
+  put32(ihdr, static_cast<std::uint32_t>(GLPbo::width));
+  put32(ihdr, static_cast<std::uint32_t>(GLPbo::height));
+  // 8 bits per channel, rgb, deflate, adaptive filtering, no interlace
+  ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 });
+
+  static unsigned char const signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  return std::fwrite(signature, 1, 8, file) == 8 && chunk("IHDR", ihdr) && chunk("IDAT", idat) && chunk("IEND", {});
+}
+
+/*  _________________________________________________________________________ */
+/*! frame_path
+@param std::string const& pattern
+file name with at most one %d for the frame index, which may have a zero
+flag and a width as in %03d, and %% for a percent sign
+@param int frame
+index of the frame
+@param std::string& path
+the file name of the frame
+@param bool& numbered
+whether the pattern has a %d, so that every frame goes to a file of its own
+@return bool
+false if the pattern has any other conversion or more than one %d.
+*/
+static bool frame_path(std::string const& pattern, int frame, std::string& path, bool& numbered) {
+  path.clear();
+  numbered = false;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] != '%') {
+      path += pattern[i];
+      continue;
+    }
+    if (i + 1 < pattern.size() && pattern[i + 1] == '%') {
+      path += '%';
+      ++i;
+      continue;
+    }
+    size_t end = i + 1;
+    bool zero = end < pattern.size() && pattern[end] == '0';
+    size_t width = 0;
+    for (; end < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[end])); ++end) {
+      width = width * 10 + (pattern[end] - '0');
+      if (width > 64) {
+        return false;
+      }
+    }
+    if (numbered || end == pattern.size() || pattern[end] != 'd') {
+      return false;
+    }
+    std::string number = std::to_string(frame);
+    if (number.size() < width) {
+      number.insert(0, width - number.size(), zero ? '0' : ' ');
+    }
+    path += number;
+    numbered = true;
+    i = end;
+  }
+  return true;
+}
+
+/*  _________________________________________________________________________ */
+/*! write_frame
+@param std::string const& name
+file name or pattern of the frame index, see frame_path, - for stdout
+@param int frame
+index of the frame
+@return bool
+false if the file could not be written.
+*/
+static bool write_frame(std::string const& name, int frame) {
+  if (name == "-") {
+    for (GLint y = GLPbo::height - 1; y >= 0; --y) {
+      std::fwrite(GLPbo::ptr_to_pbo + static_cast<size_t>(y) * GLPbo::width, sizeof(GLPbo::Color), GLPbo::width, stdout);
+    }
+    return std::fflush(stdout) == 0 && !std::ferror(stdout);
+  }
+
+  // main already turned away patterns frame_path does not take
+  std::string path;
+  bool numbered = false;
+  frame_path(name, frame, path, numbered);
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    std::cerr << "unable to open " << path << std::endl;
+    return false;
+  }
+  bool png = path.size() >= 4 && !path.compare(path.size() - 4, 4, ".png");
+  bool written = png ? write_png(file) : write_ppm(file);
+  written = std::fclose(file) == 0 && written;
+  if (!written) {
+    std::cerr << "unable to write " << path << std::endl;
+  }
+  return written;
+}